@@ -0,0 +1,651 @@
+// Micro/frame benchmarks for the hot paths. Prints one JSON object per line
+// (or CSV with --csv) so results can be diffed and plotted between builds.
+#include "AllocationCounter.h"
+#include "ColorKernels.h"
+#include "FbmNoise.h"
+#include "Heightfield.h"
+#include "Mountain.h"
+#include "RenderUtils.h"
+#include "SampleKernels.h"
+#include "Scene.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+  bool quick = false;
+  bool csv = false;
+  double minTimeMs = 200.0;
+  std::string filter;
+};
+
+struct Resolution {
+  int w, h;
+};
+
+struct Result {
+  std::string bench;
+  std::string variant;
+  int width = 0;
+  int height = 0;
+  int mountains = 0;
+  double roughness = 0.0;
+  uint64_t iters = 0;
+  double nsPerIter = 0.0;
+  double units = 0.0; // pixels (or samples) touched per iteration
+  double allocsPerIter = 0.0;
+};
+
+void printHeader(const Options &opts) {
+  if (opts.csv)
+    std::printf("bench,variant,width,height,mountains,roughness,iters,"
+                "ns_per_iter,ns_per_pixel,mpix_per_s,allocs_per_iter\n");
+}
+
+void printResult(const Options &opts, const Result &r) {
+  double nsPerPx = r.units > 0.0 ? r.nsPerIter / r.units : 0.0;
+  double mpixPerS = r.nsPerIter > 0.0 ? r.units / r.nsPerIter * 1e3 : 0.0;
+  if (opts.csv) {
+    std::printf("%s,%s,%d,%d,%d,%.3f,%llu,%.1f,%.4f,%.2f,%.2f\n",
+                r.bench.c_str(), r.variant.c_str(), r.width, r.height,
+                r.mountains, r.roughness,
+                static_cast<unsigned long long>(r.iters), r.nsPerIter, nsPerPx,
+                mpixPerS, r.allocsPerIter);
+  } else {
+    std::printf("{\"bench\":\"%s\",\"variant\":\"%s\",\"width\":%d,"
+                "\"height\":%d,\"mountains\":%d,\"roughness\":%.3f,"
+                "\"iters\":%llu,\"ns_per_iter\":%.1f,\"ns_per_pixel\":%.4f,"
+                "\"mpix_per_s\":%.2f,\"allocs_per_iter\":%.2f}\n",
+                r.bench.c_str(), r.variant.c_str(), r.width, r.height,
+                r.mountains, r.roughness,
+                static_cast<unsigned long long>(r.iters), r.nsPerIter, nsPerPx,
+                mpixPerS, r.allocsPerIter);
+  }
+  std::fflush(stdout);
+}
+
+// Run 'fn' once to warm up, then repeatedly until minTimeMs has elapsed.
+void measure(const Options &opts, Result &r, const std::function<void()> &fn) {
+  using clock = std::chrono::steady_clock;
+  fn();
+  uint64_t allocs0 = allocation_count();
+  auto t0 = clock::now();
+  auto deadline = t0 + std::chrono::duration_cast<clock::duration>(
+                           std::chrono::duration<double, std::milli>(
+                               opts.minTimeMs));
+  uint64_t iters = 0;
+  clock::time_point t1;
+  do {
+    fn();
+    ++iters;
+    t1 = clock::now();
+  } while (t1 < deadline);
+  uint64_t allocs1 = allocation_count();
+  r.iters = iters;
+  r.nsPerIter =
+      std::chrono::duration<double, std::nano>(t1 - t0).count() / double(iters);
+  r.allocsPerIter = double(allocs1 - allocs0) / double(iters);
+}
+
+bool selected(const Options &opts, const std::string &name) {
+  return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+}
+
+// Deterministic stand-in for main.cpp's random palette scenes: back-to-front
+// ridges with the same height/span ramps, fixed seeds.
+std::vector<MountainParams> makeParams(int count, int width, double roughness) {
+  std::vector<MountainParams> out;
+  out.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    double t = double(i) / double(std::max(1, count - 1));
+    MountainParams p;
+    p.width = width;
+    p.seed = 0x9E3779B9u * uint32_t(i + 1);
+    p.leftHeight = 0.05 + 0.06 * t;
+    p.rightHeight = 0.12 + 0.06 * t;
+    p.initialDisplacement = 0.9 + 0.4 * t;
+    p.roughness = roughness;
+    p.minHeight = 0;
+    p.maxHeight = 1.5 - t;
+    p.verticalSpan = 0.5 + 0.45 * t;
+    p.verticalOffset = static_cast<int>(30.0 * (1.0 + t));
+    uint8_t g = uint8_t(30 + (i * 37) % 140);
+    p.colorARGB = packARGB(0xFF, g, g, g);
+    out.push_back(std::move(p));
+  }
+  return out;
+}
+
+MountainColorScheme benchScheme() {
+  MountainColorScheme s;
+  s.skyTop = 0xFF2E3440u;
+  s.skyBottom = 0xFFD8DEE9u;
+  return s;
+}
+
+void benchGenerate(const Options &opts) {
+  std::vector<int> widths = {1024, 3840, 7680, 1 << 20};
+  std::vector<double> roughs = {0.3, 0.48, 0.7};
+  if (opts.quick) {
+    widths = {1024, 7680};
+    roughs = {0.48};
+  }
+  struct Variant {
+    const char *name;
+    RidgeAlgorithm algorithm;
+    bool threaded;
+  };
+  const Variant variants[] = {
+      {"recursive", RidgeAlgorithm::MidpointRecursive, false},
+      {"hashed_t1", RidgeAlgorithm::MidpointHashed, false},
+      {"hashed_tN", RidgeAlgorithm::MidpointHashed, true},
+  };
+  ThreadPool pool;
+  for (int w : widths)
+    for (double rough : roughs)
+      for (const auto &v : variants) {
+        MountainParams p = makeParams(1, w, rough).front();
+        p.algorithm = v.algorithm;
+        Mountain m(p);
+        Result r;
+        r.bench = "generate";
+        r.variant = v.name;
+        r.width = w;
+        r.height = 1;
+        r.mountains = 1;
+        r.roughness = rough;
+        r.units = double(w);
+        measure(opts, r,
+                [&] { m.generate(v.threaded ? &pool : nullptr); });
+        printResult(opts, r);
+      }
+}
+
+// Column tops of a 2^20-sample ridge: read from a generated pyramid versus
+// evaluated per column by the noise engine, which stores nothing.
+void benchColumns(const Options &opts, const std::vector<Resolution> &res) {
+  const int width = 1 << 20;
+  for (const auto &rs : res)
+    for (RidgeAlgorithm algorithm :
+         {RidgeAlgorithm::MidpointHashed, RidgeAlgorithm::FbmNoise}) {
+      MountainParams p = makeParams(1, width, 0.48).front();
+      p.algorithm = algorithm;
+      Mountain m(p);
+      std::vector<int16_t> tops(size_t(rs.w));
+      Result r;
+      r.bench = "columns";
+      r.variant = algorithm == RidgeAlgorithm::FbmNoise
+                      ? std::string("fbm_") + fbm_noise_isa()
+                      : std::string("pyramid");
+      r.width = rs.w;
+      r.height = rs.h;
+      r.mountains = 1;
+      r.roughness = 0.48;
+      r.units = double(rs.w);
+      measure(opts, r, [&] { m.columnTops(rs.w, rs.h, tops.data()); });
+      printResult(opts, r);
+    }
+}
+
+void benchPaint(const Options &opts, const std::vector<Resolution> &res) {
+  std::vector<double> roughs = opts.quick ? std::vector<double>{0.48}
+                                          : std::vector<double>{0.3, 0.48, 0.7};
+  for (const auto &rs : res)
+    for (double rough : roughs) {
+      std::vector<uint32_t> fb(size_t(rs.w) * rs.h, 0u);
+      Mountain m(makeParams(1, rs.w, rough).front());
+      Result r;
+      r.bench = "paint";
+      r.variant = "columns";
+      r.width = rs.w;
+      r.height = rs.h;
+      r.mountains = 1;
+      r.roughness = rough;
+      r.units = double(rs.w) * rs.h;
+      measure(opts, r, [&] { m.paint(fb.data(), rs.w, rs.w, rs.h); });
+      printResult(opts, r);
+
+      SpanRasterizer raster;
+      r.variant = std::string("spans_") + fill_span_isa();
+      measure(opts, r,
+              [&] { m.paintSpans(fb.data(), rs.w, rs.w, rs.h, raster); });
+      printResult(opts, r);
+
+      // Same fill with the silhouette cache warm: no per-column math left.
+      m.silhouette(rs.w, rs.h);
+      r.variant = std::string("spans_") + fill_span_isa() + "_cached";
+      measure(opts, r,
+              [&] { m.paintSpans(fb.data(), rs.w, rs.w, rs.h, raster); });
+      printResult(opts, r);
+    }
+}
+
+// The per-pixel double code the 8.8 kernels replaced, kept as baselines.
+uint32_t gradientRowDouble(int y, int winH, uint32_t top, uint32_t bottom) {
+  double t = double(y) / double(std::max(1, winH - 1));
+  uint32_t out = 0;
+  for (int shift = 0; shift <= 24; shift += 8) {
+    double a = (top >> shift) & 0xFF, b = (bottom >> shift) & 0xFF;
+    out |= uint32_t((1.0 - t) * a + t * b + 0.5) << shift;
+  }
+  return out;
+}
+
+void fillSkyDouble(uint32_t *pixels, int rowStride, int winW, int winH,
+                   uint32_t top, uint32_t bottom) {
+  for (int y = 0; y < winH; ++y) {
+    uint32_t rowColor = gradientRowDouble(y, winH, top, bottom);
+    uint32_t *row = pixels + size_t(y) * rowStride;
+    for (int x = 0; x < winW; ++x)
+      row[x] = rowColor;
+  }
+}
+
+uint32_t scaleColorDouble(uint32_t c, double factor) {
+  uint32_t out = c & 0xFF000000u;
+  for (int shift = 0; shift <= 16; shift += 8)
+    out |= uint32_t(std::min(255.0, double((c >> shift) & 0xFF) * factor))
+           << shift;
+  return out;
+}
+
+void benchSky(const Options &opts, const std::vector<Resolution> &res) {
+  MountainColorScheme cs = benchScheme();
+  for (const auto &rs : res) {
+    std::vector<uint32_t> fb(size_t(rs.w) * rs.h, 0u);
+    Result r;
+    r.bench = "sky";
+    r.variant = "double_lerp";
+    r.width = rs.w;
+    r.height = rs.h;
+    r.units = double(rs.w) * rs.h;
+    measure(opts, r, [&] {
+      fillSkyDouble(fb.data(), rs.w, rs.w, rs.h, cs.skyTop, cs.skyBottom);
+    });
+    printResult(opts, r);
+
+    r.variant = std::string("q8_") + fill_span_isa();
+    measure(opts, r, [&] {
+      fill_vertical_gradient(fb.data(), rs.w, rs.w, rs.h, cs.skyTop,
+                             cs.skyBottom);
+    });
+    printResult(opts, r);
+
+    // Half the bytes per pixel.
+    std::vector<uint16_t> fb16(size_t(rs.w) * rs.h, 0u);
+    r.variant = std::string("q8_rgb565_") + fill_span_isa();
+    measure(opts, r, [&] {
+      fill_vertical_gradient(fb16.data(), rs.w, rs.w, rs.h, cs.skyTop,
+                             cs.skyBottom);
+    });
+    printResult(opts, r);
+  }
+}
+
+// Whole-frame color passes: the 8.8 span kernels against the per-pixel
+// double helpers they replace.
+void benchColor(const Options &opts, const std::vector<Resolution> &res) {
+  const uint32_t fog = 0xFFC8D0D8u;
+  for (const auto &rs : res) {
+    const size_t n = size_t(rs.w) * rs.h;
+    std::vector<uint32_t> src(n), dst(n);
+    for (size_t i = 0; i < n; ++i)
+      src[i] = 0x80000000u | uint32_t(i * 0x9E3779B9u >> 8);
+    Result r;
+    r.bench = "color";
+    r.width = rs.w;
+    r.height = rs.h;
+    r.units = double(n);
+    const std::string isa = color_kernels_isa();
+
+    r.variant = "lerp_double";
+    measure(opts, r, [&] {
+      for (size_t i = 0; i < n; ++i)
+        dst[i] = lerpColor(src[i], fog, 0.4);
+    });
+    printResult(opts, r);
+    r.variant = "lerp_q8_" + isa;
+    measure(opts, r,
+            [&] { lerp_span(dst.data(), src.data(), int(n), fog, 102); });
+    printResult(opts, r);
+
+    r.variant = "scale_double";
+    measure(opts, r, [&] {
+      for (size_t i = 0; i < n; ++i)
+        dst[i] = scaleColorDouble(src[i], 1.25);
+    });
+    printResult(opts, r);
+    r.variant = "scale_q8_" + isa;
+    measure(opts, r, [&] { scale_span(dst.data(), src.data(), int(n), 320); });
+    printResult(opts, r);
+
+    r.variant = "over_q8_" + isa;
+    measure(opts, r, [&] { over_span(dst.data(), src.data(), int(n)); });
+    printResult(opts, r);
+  }
+}
+
+void benchScene(const Options &opts, const std::vector<Resolution> &res) {
+  std::vector<int> counts = {1, 10, 100, 1000};
+  if (opts.quick)
+    counts = {1, 10};
+  const double rough = 0.48;
+  struct Variant {
+    const char *name;
+    CompositeMode composite;
+    RasterMode raster;
+    bool threaded;
+    bool antiAlias;
+    PixelFormat format = PixelFormat::ARGB8888;
+  };
+  const Variant variants[] = {
+      {"painter", CompositeMode::Painter, RasterMode::Columns, false, false},
+      {"painter_spans", CompositeMode::Painter, RasterMode::Spans, false,
+       false},
+      {"painter_spans_aa", CompositeMode::Painter, RasterMode::Spans, false,
+       true},
+      {"front_to_back", CompositeMode::FrontToBack, RasterMode::Columns, false,
+       false},
+      {"front_to_back_spans", CompositeMode::FrontToBack, RasterMode::Spans,
+       false, false},
+      {"front_to_back_spans_mt", CompositeMode::FrontToBack, RasterMode::Spans,
+       true, false},
+      {"front_to_back_spans_xrgb", CompositeMode::FrontToBack,
+       RasterMode::Spans, false, false, PixelFormat::XRGB8888},
+      {"front_to_back_spans_rgb565", CompositeMode::FrontToBack,
+       RasterMode::Spans, false, false, PixelFormat::RGB565},
+      {"painter_spans_aa_xrgb", CompositeMode::Painter, RasterMode::Spans,
+       false, true, PixelFormat::XRGB8888},
+      {"painter_spans_aa_rgb565", CompositeMode::Painter, RasterMode::Spans,
+       false, true, PixelFormat::RGB565},
+  };
+  auto pool = std::make_shared<ThreadPool>();
+  for (const auto &rs : res)
+    for (int count : counts) {
+      std::vector<uint32_t> fb(size_t(rs.w) * rs.h, 0u);
+      Scene scene(rs.w, rs.h, benchScheme());
+      scene.setMountains(makeParams(count, rs.w, rough));
+      for (const auto &v : variants) {
+        scene.setCompositeMode(v.composite);
+        scene.setRasterMode(v.raster);
+        scene.setThreadPool(v.threaded ? pool : nullptr);
+        scene.setAntiAliasing(v.antiAlias);
+        Result r;
+        r.bench = "scene_render";
+        r.variant = v.name;
+        r.width = rs.w;
+        r.height = rs.h;
+        r.mountains = count;
+        r.roughness = rough;
+        r.units = double(rs.w) * rs.h;
+        measure(opts, r, [&] {
+          scene.markDirty();
+          scene.render(fb.data(), rs.w, v.format);
+        });
+        printResult(opts, r);
+      }
+      // Retained mode: an unchanged scene served from the frame cache.
+      scene.setThreadPool(nullptr);
+      scene.setFrameCacheEnabled(true);
+      Result r;
+      r.bench = "scene_render";
+      r.variant = "cached_clean";
+      r.width = rs.w;
+      r.height = rs.h;
+      r.mountains = count;
+      r.roughness = rough;
+      r.units = double(rs.w) * rs.h;
+      measure(opts, r, [&] { scene.render(fb.data(), rs.w); });
+      printResult(opts, r);
+    }
+}
+
+void benchBuild(const Options &opts) {
+  std::vector<int> counts = {100, 1000};
+  if (opts.quick)
+    counts = {100};
+  const int width = 1920;
+  auto pool = std::make_shared<ThreadPool>();
+  for (int count : counts)
+    for (bool threaded : {false, true}) {
+      Scene scene(width, 1080, benchScheme());
+      scene.setThreadPool(threaded ? pool : nullptr);
+      Result r;
+      r.bench = "scene_build";
+      r.variant = threaded ? "batch_pool" : "batch_serial";
+      r.width = width;
+      r.height = 1;
+      r.mountains = count;
+      r.roughness = 0.48;
+      r.units = double(count) * width;
+      measure(opts, r, [&] {
+        scene.buildMountains(makeParams(count, width, 0.48), 0xC0FFEEull);
+      });
+      printResult(opts, r);
+    }
+
+  // Regeneration as the viewer does it: a new scene per rebuild, rendered
+  // once, either from scratch or in the storage of the scene it replaces.
+  for (bool recycled : {false, true}) {
+    const int count = 8, height = 1080;
+    std::vector<uint32_t> fb(size_t(width) * height);
+    auto scene = std::make_unique<Scene>(width, height, benchScheme());
+    uint64_t seed = 0xC0FFEEull;
+    Result r;
+    r.bench = "scene_build";
+    r.variant = recycled ? "rebuild_recycled" : "rebuild_fresh";
+    r.width = width;
+    r.height = height;
+    r.mountains = count;
+    r.roughness = 0.48;
+    r.units = double(count) * width;
+    measure(opts, r, [&] {
+      auto next = std::make_unique<Scene>(width, height, benchScheme());
+      if (recycled)
+        next->recycle(std::move(*scene));
+      next->buildMountains(makeParams(count, width, 0.48), ++seed);
+      next->render(fb.data(), width);
+      scene = std::move(next);
+    });
+    printResult(opts, r);
+  }
+
+  // The same scenes opened from scene files with their pyramids stored.
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "mountains_bench.scene")
+          .string();
+  for (int count : counts) {
+    Scene scene(width, 1080, benchScheme());
+    scene.buildMountains(makeParams(count, width, 0.48), 0xC0FFEEull);
+    if (!scene.save(path))
+      continue;
+    Result r;
+    r.bench = "scene_build";
+    r.variant = "file_load";
+    r.width = width;
+    r.height = 1;
+    r.mountains = count;
+    r.roughness = 0.48;
+    r.units = double(count) * width;
+    measure(opts, r, [&] { Scene::load(path); });
+    printResult(opts, r);
+  }
+  std::remove(path.c_str());
+}
+
+// One animation step of a seed morph (the blend and the silhouette built
+// from it) against rebuilding the silhouette after a seed change.
+void benchMorph(const Options &opts, const std::vector<Resolution> &res) {
+  for (const auto &rs : res) {
+    MountainParams p = makeParams(1, rs.w, 0.48).front();
+    MountainParams q = p;
+    q.seed ^= 0x5EEDu;
+    Mountain m(p);
+    m.beginMorph(std::make_shared<Mountain>(q));
+    m.silhouette(rs.w, rs.h);
+    double t = 0.0;
+    Result r;
+    r.bench = "morph";
+    r.variant = std::string("step_") + sample_kernels_isa();
+    r.width = rs.w;
+    r.height = rs.h;
+    r.mountains = 1;
+    r.roughness = 0.48;
+    r.units = double(rs.w);
+    measure(opts, r, [&] {
+      t = t < 1.0 ? t + 1.0 / 64.0 : 0.0;
+      m.setMorphWeight(t);
+      m.silhouette(rs.w, rs.h);
+    });
+    printResult(opts, r);
+
+    Mountain g(p);
+    r.variant = "regenerate";
+    measure(opts, r, [&] {
+      g.regenerate(++p.seed);
+      g.silhouette(rs.w, rs.h);
+    });
+    printResult(opts, r);
+  }
+}
+
+// One pointer edit on a very wide ridge (a brush of 1/16 of the window)
+// against regenerating the whole ridge.
+void benchSculpt(const Options &opts, const std::vector<Resolution> &res) {
+  const int width = 1 << 22;
+  for (const auto &rs : res) {
+    MountainParams p = makeParams(1, width, 0.48).front();
+    Mountain m(p);
+    Result r;
+    r.bench = "sculpt";
+    r.variant = "edit";
+    r.width = rs.w;
+    r.height = rs.h;
+    r.mountains = 1;
+    r.roughness = 0.48;
+    r.units = double(rs.w);
+    int x = 0;
+    measure(opts, r, [&] {
+      x = (x + 37) % rs.w;
+      m.sculpt(x, rs.h / 2, rs.w, rs.h, rs.w / 16);
+      m.silhouette(rs.w, rs.h);
+    });
+    printResult(opts, r);
+  }
+  MountainParams p = makeParams(1, width, 0.48).front();
+  Mountain m(p);
+  Result r;
+  r.bench = "sculpt";
+  r.variant = "regenerate";
+  r.width = width;
+  r.height = 1;
+  r.mountains = 1;
+  r.roughness = 0.48;
+  r.units = double(width);
+  measure(opts, r, [&] { m.regenerate(++p.seed); });
+  printResult(opts, r);
+}
+
+void benchTerrain(const Options &opts) {
+  std::vector<int> sizes = {1025, 2049, 4097};
+  if (opts.quick)
+    sizes = {1025, 2049};
+  auto pool = std::make_shared<ThreadPool>();
+  for (int size : sizes) {
+    MountainParams p = makeParams(1, size, 0.55).front();
+    Heightfield terrain;
+    for (bool threaded : {false, true}) {
+      Result r;
+      r.bench = "terrain";
+      r.variant = threaded ? "diamond_square_pool" : "diamond_square";
+      r.width = size;
+      r.height = size;
+      r.mountains = 1;
+      r.roughness = p.roughness;
+      r.units = double(size) * size;
+      measure(opts, r, [&] {
+        terrain.generate(p, threaded ? pool.get() : nullptr);
+      });
+      printResult(opts, r);
+    }
+    // Horizons of six depth bands, as HeightfieldLayer cuts them.
+    std::vector<double> horizon(static_cast<size_t>(size));
+    Result r;
+    r.bench = "terrain";
+    r.variant = "band_horizons";
+    r.width = size;
+    r.height = size;
+    r.mountains = 6;
+    r.roughness = p.roughness;
+    r.units = double(size) * size;
+    measure(opts, r, [&] {
+      for (int b = 0; b < 6; ++b)
+        terrain.rowMax(size * b / 6, size * (b + 1) / 6, horizon.data());
+    });
+    printResult(opts, r);
+  }
+}
+
+void printUsage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--quick] [--csv] [--min-time MS] [--filter NAME]\n"
+               "  benches: generate, columns, paint, sky, color,\n"
+               "           scene_render, scene_build, morph, sculpt, terrain\n",
+               argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--quick") == 0)
+      opts.quick = true;
+    else if (std::strcmp(argv[i], "--csv") == 0)
+      opts.csv = true;
+    else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+      opts.minTimeMs = std::atof(argv[++i]);
+    else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+      opts.filter = argv[++i];
+    else {
+      printUsage(argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<Resolution> res = {
+      {1024, 512}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+  if (opts.quick)
+    res = {{1024, 512}, {1920, 1080}};
+
+  printHeader(opts);
+  if (selected(opts, "generate"))
+    benchGenerate(opts);
+  if (selected(opts, "columns"))
+    benchColumns(opts, res);
+  if (selected(opts, "paint"))
+    benchPaint(opts, res);
+  if (selected(opts, "sky"))
+    benchSky(opts, res);
+  if (selected(opts, "color"))
+    benchColor(opts, res);
+  if (selected(opts, "scene_render"))
+    benchScene(opts, res);
+  if (selected(opts, "scene_build"))
+    benchBuild(opts);
+  if (selected(opts, "morph"))
+    benchMorph(opts, res);
+  if (selected(opts, "sculpt"))
+    benchSculpt(opts, res);
+  if (selected(opts, "terrain"))
+    benchTerrain(opts);
+  return 0;
+}
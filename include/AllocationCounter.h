@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+// Global allocation counting, for checking that steady-state frames do not
+// allocate and that rebuilds allocate a bounded amount. AllocationCounter.cpp
+// replaces the global operator new and delete with malloc and free plus one
+// relaxed atomic and one thread-local increment per new, for the whole
+// program that links it. It is therefore not part of mountains_core: only
+// the benchmark and the tests link the mountains_alloc_counter target, and
+// the viewer keeps the standard allocator.
+
+// Number of global operator new calls (all forms) so far, on any thread.
+uint64_t allocation_count() noexcept;
+// The calling thread's share of allocation_count(), for work that leaves
+// some allocations to other threads on purpose.
+uint64_t thread_allocation_count() noexcept;
+
+// Allocations made since construction, e.g. around one frame.
+class AllocationScope {
+public:
+  AllocationScope() noexcept : start_(allocation_count()) {}
+  uint64_t count() const noexcept { return allocation_count() - start_; }
+
+private:
+  uint64_t start_;
+};
+
+// Allocations the constructing thread made since construction.
+class ThreadAllocationScope {
+public:
+  ThreadAllocationScope() noexcept : start_(thread_allocation_count()) {}
+  uint64_t count() const noexcept {
+    return thread_allocation_count() - start_;
+  }
+
+private:
+  uint64_t start_;
+};
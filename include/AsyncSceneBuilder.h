@@ -0,0 +1,53 @@
+#pragma once
+#include "Scene.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Builds scenes on a background thread so the frame loop keeps rendering the
+// current one. Requests coalesce: submitting while a build is queued replaces
+// it, and a build in progress is told to stop. Finished scenes are picked up
+// with takeReady() at a frame boundary and swapped in by the caller, who
+// hands the scene it replaced back with retire(): the next job can build
+// into its storage, and whatever it does not reuse is freed on the worker
+// instead of the frame thread.
+class AsyncSceneBuilder {
+public:
+  // Returns true once the job has been superseded; jobs should poll it
+  // between steps and return nullptr when it fires.
+  using CancelCheck = std::function<bool()>;
+  // 'retired' is the last scene passed to retire(), or null; the job may
+  // take its storage with Scene::recycle().
+  using Job = std::function<std::unique_ptr<Scene>(Scene *retired,
+                                                   const CancelCheck &)>;
+
+  AsyncSceneBuilder();
+  ~AsyncSceneBuilder();
+  AsyncSceneBuilder(const AsyncSceneBuilder &) = delete;
+  AsyncSceneBuilder &operator=(const AsyncSceneBuilder &) = delete;
+
+  void submit(Job job);
+  // The newest completed scene, or null. Never blocks on a running build.
+  std::unique_ptr<Scene> takeReady();
+  // Hand over a scene that is no longer drawn, replacing any earlier one.
+  void retire(std::unique_ptr<Scene> scene);
+  // True while a job is queued or running.
+  bool busy() const;
+
+private:
+  void workerLoop();
+
+  mutable std::mutex m_;
+  std::condition_variable cv_;
+  Job pending_;
+  std::unique_ptr<Scene> ready_;
+  std::unique_ptr<Scene> retired_;
+  bool running_ = false;
+  bool stop_ = false;
+  std::atomic<uint64_t> latest_{0}; // ticket of the newest submission
+  std::thread worker_;
+};
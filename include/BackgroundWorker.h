@@ -0,0 +1,47 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// One process-wide thread for background work that must not hold up a frame
+// but is too small to deserve a thread of its own, such as RidgeMorpher's
+// next targets. Jobs run one at a time in the order they were posted. They
+// are intrusive: the owner embeds its Job, so posting never allocates.
+class BackgroundWorker {
+public:
+  class Job {
+  public:
+    virtual void run() = 0;
+
+  protected:
+    ~Job() = default;
+
+  private:
+    friend class BackgroundWorker;
+    Job *next_ = nullptr;
+    bool queued_ = false; // guarded by the worker's mutex
+  };
+
+  static BackgroundWorker &instance();
+  ~BackgroundWorker();
+  BackgroundWorker(const BackgroundWorker &) = delete;
+  BackgroundWorker &operator=(const BackgroundWorker &) = delete;
+
+  // Queue 'job' unless it is queued already.
+  void post(Job &job);
+  // Unqueue 'job', or wait for it to finish if it is running. Afterwards
+  // the worker no longer touches it, so its owner may be destroyed.
+  void cancel(Job &job);
+
+private:
+  BackgroundWorker();
+  void workerLoop();
+
+  std::mutex m_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  Job *head_ = nullptr, *tail_ = nullptr;
+  Job *running_ = nullptr;
+  bool stop_ = false;
+  std::thread worker_;
+};
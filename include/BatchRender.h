@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+enum class BatchPalette : uint8_t { Nord, Everforest, Random };
+
+struct BatchOptions {
+  uint64_t firstSeed = 1;
+  uint64_t lastSeed = 1; // inclusive
+  int width = 1920;
+  int height = 1080;
+  size_t mountains = 3;
+  BatchPalette palette = BatchPalette::Nord;
+  bool antiAlias = false;
+  std::string outDir = ".";
+  std::string format = "png"; // "png" or "ppm"
+  int threads = 0;            // per stage (0 = all cores)
+};
+
+struct BatchStats {
+  uint64_t images = 0; // written successfully
+  uint64_t failed = 0;
+  std::string firstFailure; // path of the first image that failed to write
+  double seconds = 0.0;
+  double imagesPerSecond() const {
+    return seconds > 0.0 ? double(images) / seconds : 0.0;
+  }
+};
+
+// Render one image per scene seed in [firstSeed, lastSeed] to
+// outDir/mountains_<seed>.<format>, without a window. Each seed produces the
+// same image as `mountains --seed <seed>` with the same size, palette,
+// mountain count and anti-aliasing.
+//
+// Three stages run concurrently: generate (ridges for a seed), render
+// (Scene::render into a fresh frame) and encode (compress and write). They
+// hand work along through bounded queues, so at most a few images per
+// thread are in flight. Stage costs swing with resolution and format (PPM
+// is nearly free to encode, PNG is not), so instead of guessing a split,
+// every stage gets 'threads' workers and the queues decide which of them
+// run: a stage blocked on a full or empty queue sleeps and leaves its cores
+// to the bottleneck.
+BatchStats render_batch(const BatchOptions &opts);
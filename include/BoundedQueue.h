@@ -0,0 +1,62 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// Blocking multi-producer, multi-consumer FIFO with a fixed capacity.
+// Connects pipeline stages: a full queue stalls the producer, so a fast
+// stage cannot run ahead of a slow one and pile up work (and memory).
+template <class T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1) {}
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  // Wait for room and append. Returns false (dropping 'v') once closed.
+  bool push(T v) {
+    std::unique_lock<std::mutex> lock(m_);
+    notFull_.wait(lock, [&] { return closed_ || items_.size() < capacity_; });
+    if (closed_)
+      return false;
+    items_.push_back(std::move(v));
+    lock.unlock();
+    notEmpty_.notify_one();
+    return true;
+  }
+
+  // Wait for an item. Returns false once the queue is closed and drained.
+  bool pop(T &out) {
+    std::unique_lock<std::mutex> lock(m_);
+    notEmpty_.wait(lock, [&] { return closed_ || !items_.empty(); });
+    if (items_.empty())
+      return false;
+    out = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    notFull_.notify_one();
+    return true;
+  }
+
+  // No more pushes; consumers drain what is left and then see false.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(m_);
+      closed_ = true;
+    }
+    notFull_.notify_all();
+    notEmpty_.notify_all();
+  }
+
+  size_t capacity() const { return capacity_; }
+
+private:
+  const size_t capacity_;
+  std::mutex m_;
+  std::condition_variable notFull_;
+  std::condition_variable notEmpty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include "MountainParams.h"
+#include <cstdint>
+#include <vector>
+
+// An endless ridge generated on demand in fixed-size chunks.
+//
+// Chunk c covers world samples [c * span, (c + 1) * span], span = 2^levels.
+// Its two endpoints are boundary values hashed from (seed, boundary index),
+// so neighbouring chunks share them exactly and join without a seam; the
+// interior is counter-based midpoint displacement keyed by (seed, chunk
+// index). Any chunk can be rebuilt at any time with identical results, which
+// lets a small LRU cache hold only the chunks near the view: memory and work
+// per frame stay the same however far the ridge has scrolled.
+//
+// Heights map to [0, 1] through fixed bounds derived from the parameters
+// (not per-chunk min/max, which would break the seams), then through
+// minHeight/maxHeight/verticalSpan like Mountain. params.width is the number
+// of samples spread across the window.
+class ChunkedRidge {
+public:
+  // 'cacheChunks' bounds the cache; it should hold every chunk a window
+  // touches plus one, or chunks are regenerated every frame.
+  explicit ChunkedRidge(MountainParams params, int chunkLevels = 9,
+                        int cacheChunks = 4);
+
+  // Normalized heights of world samples [first, first + count).
+  void sample(int64_t first, int count, double *out);
+  // Silhouette row of each of winW columns whose leftmost column shows world
+  // sample 'first'.
+  void columnTops(int64_t first, int winW, int winH, int16_t *out);
+
+  const MountainParams &params() const noexcept { return params_; }
+  int chunkSpan() const noexcept { return span_; }
+  int cacheCapacity() const noexcept { return int(cache_.size()); }
+  // Chunks generated since construction (cache misses).
+  uint64_t chunksGenerated() const noexcept { return generated_; }
+
+private:
+  struct Chunk {
+    int64_t index = 0;
+    uint64_t lastUse = 0; // 0 = empty slot
+    std::vector<double> h;
+  };
+
+  const double *chunk(int64_t index);
+  double boundary(int64_t i) const noexcept;
+
+  MountainParams params_;
+  int levels_;
+  int span_;
+  uint64_t key_;
+  uint64_t boundaryKey_;
+  double center_, amplitude_; // boundary values: center +- amplitude
+  double disp_;               // level-0 displacement inside a chunk
+  double lo_, scale_;         // raw height -> [0, 1]
+  std::vector<Chunk> cache_;
+  uint64_t useClock_ = 0;
+  uint64_t generated_ = 0;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+// Batch color kernels in 8.8 fixed point. Weights are in [0, 256], 256
+// meaning all of the second color, and every channel rounds to nearest, the
+// same as blend_argb_q8(). Like fill_span(), each picks AVX2, SSE2 or scalar
+// code once at first use; all three give identical pixels. 'dst' may equal
+// 'src'.
+
+// dst[i] = src[i] + (color - src[i]) * t / 256, all four channels.
+void lerp_span(uint32_t *dst, const uint32_t *src, int count, uint32_t color,
+               uint32_t t);
+// RGB times factor / 256 (factor < 65536), saturating at 255; alpha kept.
+void scale_span(uint32_t *dst, const uint32_t *src, int count,
+                uint32_t factor);
+// src[i] over dst[i] by src alpha (255 = opaque); dst alpha kept.
+void over_span(uint32_t *dst, const uint32_t *src, int count);
+// Name of the kernels the span functions dispatch to.
+const char *color_kernels_isa();
+
+// Colors of 'count' rows fading evenly from 'first' to 'last' inclusive.
+// Rows are few, so this is scalar; fills use fill_span() per row.
+void gradient_rows(uint32_t *out, int count, uint32_t first, uint32_t last);
+// Fill columns [x0, x1) of rows [y0, y1) with rowColors[y], rows already in
+// the output format (gradient_rows(), then pack_rows() for RGB565).
+void fill_gradient_rows(uint32_t *pixels, int rowStride, int x0, int x1,
+                        int y0, int y1, const uint32_t *rowColors);
+void fill_gradient_rows(uint16_t *pixels, int rowStride, int x0, int x1,
+                        int y0, int y1, const uint16_t *rowColors);
+// Fill a width x height image with a vertical gradient from 'top' to
+// 'bottom'. The 16-bit overload writes RGB565, packing each row's color.
+void fill_vertical_gradient(uint32_t *pixels, int rowStride, int width,
+                            int height, uint32_t top, uint32_t bottom);
+void fill_vertical_gradient(uint16_t *pixels, int rowStride, int width,
+                            int height, uint32_t top, uint32_t bottom);
@@ -0,0 +1,6 @@
+#pragma once
+
+// Runtime x86 feature checks for kernels that dispatch between SSE2 and AVX2.
+// Both return false on other architectures, where scalar kernels are used.
+bool cpu_has_sse2() noexcept;
+bool cpu_has_avx2() noexcept;
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+// 1D fractal Brownian motion: a sum of gradient-noise octaves, each at twice
+// the frequency of the one before. Every value is a pure function of x, so
+// any sample costs O(octaves) with no neighbours and no array.
+//
+// Octave o hashes its lattice points floor(x * frequency * 2^o) and the next
+// one from (seed, o) to gradients in [-1, 1), blends them with the quintic
+// fade and scales the result to about [-1, 1]; it is zero on lattice points.
+// Lattice coordinates must stay inside +-2^31.
+//
+// Like the color kernels (ColorKernels.h), fbm_noise() picks AVX2 (eight x
+// at a time) or scalar code once at first use. Both do the same double
+// operations in the same order, so results are bit-identical.
+
+constexpr int kFbmMaxOctaves = 31;
+
+struct FbmSpec {
+  uint32_t seed = 0;
+  int octaves = 0;         // at most kFbmMaxOctaves
+  double frequency = 1.0;  // lattice cells per unit of x at octave 0
+  double amplitude[kFbmMaxOctaves] = {};
+};
+
+// Variance of one octave of amplitude 1 over uniformly random x.
+constexpr double kFbmOctaveVariance = 0.0792;
+
+// out[i] = sum over octaves of amplitude[o] * noise_o(x[i]).
+void fbm_noise(const FbmSpec &spec, const double *x, int count, double *out);
+// Name of the kernel fbm_noise() dispatches to.
+const char *fbm_noise_isa();
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+
+// Paces the frame loop to a target rate. Each frame gets a deadline one
+// period after the previous one; endFrame() waits only for what is left of
+// the budget, so a frame whose present() already blocked on vsync does not
+// wait again. The wait sleeps until shortly before the deadline and spins
+// the rest, with the spin margin tracking how late sleeps actually wake;
+// frames that presented nothing only sleep.
+class FramePacer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // 'targetHz' <= 0 runs uncapped: endFrame() never waits.
+  explicit FramePacer(double targetHz = 60.0);
+
+  void setTargetRate(double hz);
+  double targetRate() const { return targetHz_; }
+  bool uncapped() const { return targetHz_ <= 0.0; }
+  // Whether an uncapped frame that presented nothing sleeps (default on).
+  // Headless runs turn it off: nobody is waiting on their frames, and a
+  // sleep per idle frame would cap their throughput.
+  void setIdleSleep(bool on) { idleSleep_ = on; }
+  bool idleSleep() const { return idleSleep_; }
+
+  // Start a frame. Returns seconds since the previous beginFrame() (0 for
+  // the first frame), for use as the update step.
+  double beginFrame();
+  // Finish a frame after present(): record its cost and wait for the
+  // deadline. A frame that presented nothing has nothing to show on time,
+  // so it sleeps through the wait instead of spinning its end; uncapped, it
+  // sleeps a millisecond rather than not at all, so an idle loop does not
+  // busy-wait (see setIdleSleep()).
+  void endFrame(bool presented = true);
+
+  // Work time of the last frame (beginFrame() to endFrame()), excluding
+  // the wait.
+  double lastFrameSeconds() const { return lastCost_; }
+
+private:
+  void waitUntil(Clock::time_point deadline, bool spin);
+
+  double targetHz_ = 0.0;
+  Clock::duration period_{};
+  Clock::time_point frameStart_{};
+  Clock::time_point deadline_{};
+  bool started_ = false;
+  bool idleSleep_ = true;
+  double lastCost_ = 0.0;
+  Clock::duration spinMargin_;
+};
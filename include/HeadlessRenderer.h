@@ -0,0 +1,73 @@
+#pragma once
+#include "IRenderer.h"
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Offscreen IRenderer: keeps the last uploaded frame in memory and replays a
+// scripted event sequence instead of reading a window system. Used on boxes
+// without a display and to measure frame throughput without vsync.
+class HeadlessRenderer : public IRenderer {
+public:
+  HeadlessRenderer() = default;
+  ~HeadlessRenderer() override = default;
+
+  // IRenderer interface
+  // Any format works; without a request frames are ARGB8888.
+  void requestPixelFormat(PixelFormat format) override;
+  bool init(int width, int height, const char *title) override;
+  PixelFormat pixelFormat() const override { return format_; }
+  void updateTexture(const void *pixels,
+                     int pitch) override; // pitch in bytes
+  // Hands out the staging buffer; present() then swaps it in without a copy.
+  FrameBuffer beginFrame() override;
+  void endFrame() override;
+  void present() override;
+
+  // Each call hands out the next scripted batch (possibly empty), applying
+  // any Resize in it.
+  // Returns false once the frame limit is reached or a Quit event is replayed.
+  bool pollEvents(std::vector<Event> &outEvents) override;
+
+  void cleanup() override;
+
+  // Queue one batch of events, delivered by a single pollEvents() call.
+  void scriptEvents(std::vector<Event> batch);
+  // Convenience: queue a KeyDown/KeyUp pair as its own batch.
+  void scriptKey(int code);
+  // Queue a Resize event; the buffers take the new size when it is polled.
+  void scriptResize(int width, int height);
+  // Stop after this many frames, counted as pollEvents() calls since the
+  // loop may skip present() for frames that did not change (0 = no limit).
+  void setFrameLimit(uint64_t frames) { frameLimit_ = frames; }
+
+  // Last presented frame, rows of width() pixelFormat() pixels, packed.
+  const std::vector<uint32_t> &frame() const { return frame_; }
+  int width() const { return width_; }
+  int height() const { return height_; }
+  uint64_t framesPresented() const { return framesPresented_; }
+
+  // Dump the last presented frame, converted to ARGB8888; ".ppm" writes
+  // PPM, ".png" PNG, anything else raw ARGB.
+  bool saveFrame(const std::string &path) const;
+
+private:
+  bool resize(int width, int height);
+  size_t rowBytes() const {
+    return size_t(width_) * size_t(pixel_format_bytes(format_));
+  }
+
+  // Frames are rows of packed pixels in format_, held in whole words.
+  std::vector<uint32_t> staging_; // next frame (upload or beginFrame)
+  std::vector<uint32_t> frame_;   // last presented frame
+  PixelFormat requested_ = PixelFormat::ARGB8888;
+  PixelFormat format_ = PixelFormat::ARGB8888;
+  bool staged_ = false;           // staging_ holds a frame not yet shown
+  std::deque<std::vector<Event>> script_;
+  uint64_t frameLimit_ = 0;
+  uint64_t framesPresented_ = 0;
+  uint64_t framesPolled_ = 0;
+  int width_ = 0;
+  int height_ = 0;
+};
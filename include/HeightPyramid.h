@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Mip chain of a height profile. Level 0 is the samples themselves; each
+// further level halves the count, keeping the min, max and average of the
+// two entries below. Resampling to any output width then reads at most a
+// few entries per column from the level matching the column's footprint:
+// O(width) per viewport size, no regeneration, and every sample under a
+// column contributes, so minified ridges do not shimmer as the size changes.
+class HeightPyramid {
+public:
+  enum class Filter : uint8_t {
+    Min,
+    Max,     // highest point under the column (keeps thin peaks visible)
+    Average,
+  };
+
+  void build(const double *samples, int count);
+  // Samples [first, last] changed: copy them in and rebuild the entries
+  // above them, O(last - first + levels()). Attached pyramids are
+  // read-only and ignore this.
+  void update(const double *samples, int first, int last);
+  // Use storageSize(count) doubles laid out exactly as build() lays out its
+  // own storage, in place and without copying (e.g. a memory-mapped scene
+  // file). 'owner' keeps the memory alive for as long as any copy of the
+  // pyramid refers to it.
+  void attach(const double *storage, int count,
+              std::shared_ptr<const void> owner);
+  // The whole pyramid as one array, as attach() expects it.
+  const double *storage() const {
+    return external_ ? external_ : data_.data();
+  }
+  size_t storageSize() const;
+  static size_t storageSize(int count);
+  int size() const { return levels_.empty() ? 0 : int(levels_[0].count); }
+  int levels() const { return int(levels_.size()); }
+
+  // Heights for 'width' columns spread evenly over all samples. Wider
+  // outputs point-sample like the unfiltered path; narrower ones reduce each
+  // column's footprint with 'filter'.
+  void resample(int width, Filter filter, double *out) const;
+
+private:
+  struct Level {
+    size_t count;
+    size_t avg, min, max; // offsets into storage(); level 0: only avg
+  };
+  void layout(int count);
+  // Rebuild entries [i0, i1) of level k (>= 1) from level k - 1.
+  void reduce(size_t k, size_t i0, size_t i1);
+
+  std::vector<Level> levels_;
+  std::vector<double> data_;
+  const double *external_ = nullptr; // attached storage, used instead
+  std::shared_ptr<const void> owner_;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "MountainParams.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Square terrain from diamond-square, the 2D counterpart of a ridge.
+//
+// The grid is (2^k + 1)^2 samples, the smallest at least params.width on a
+// side. The four corners start at leftHeight (x = 0) and rightHeight
+// (x = size - 1); level l then sets the centers of its 2^l x 2^l cells
+// (diamond step) and the midpoints of their edges (square step), each the
+// average of its existing neighbours plus initialDisplacement * roughness^l
+// times a value hashed from (seed, step, x, y) like midpoint_random(). As in
+// Mountain, the result is normalized to [0, 1]. Every point of a step
+// depends only on earlier steps, so each step is a parallel loop over rows
+// and the terrain is identical for any thread count.
+//
+// Samples are floats in 8x8 tiles stored row-major by tile: a tile is four
+// cache lines, neighbours at the fine levels share one, and cutting a
+// band of rows (rowMax()) reads whole tiles. 4097^2 samples take 67 MB.
+class Heightfield {
+public:
+  static constexpr int kTileBits = 3;
+  static constexpr int kTile = 1 << kTileBits;
+
+  // 'pool' runs the large steps in parallel; null generates serially.
+  void generate(const MountainParams &params, ThreadPool *pool = nullptr);
+
+  // Samples per side; 0 before generate().
+  int size() const noexcept { return n_; }
+  float at(int x, int y) const noexcept { return data_[index(x, y)]; }
+  // out[x] = highest sample in column x over rows [y0, y1), for all size()
+  // columns: the ridge line of that band seen from the y = 0 edge.
+  void rowMax(int y0, int y1, double *out) const;
+
+  // index(x, y) == rowOffset(y) + colOffset(x), so loops along a row hoist
+  // the row part.
+  size_t index(int x, int y) const noexcept {
+    return rowOffset(y) + colOffset(x);
+  }
+  size_t rowOffset(int y) const noexcept {
+    return (size_t(y >> kTileBits) * size_t(tilesX_) << (2 * kTileBits)) +
+           size_t((y & (kTile - 1)) << kTileBits);
+  }
+  static size_t colOffset(int x) noexcept {
+    return (size_t(x >> kTileBits) << (2 * kTileBits)) +
+           size_t(x & (kTile - 1));
+  }
+
+private:
+  int n_ = 0;
+  int tilesX_ = 0;
+  std::vector<float> data_;
+};
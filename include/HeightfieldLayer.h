@@ -0,0 +1,34 @@
+#pragma once
+#include "Heightfield.h"
+#include "MountainLayer.h"
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+// Ridges cut from one Heightfield instead of generated one by one, so every
+// ridge of the view belongs to the same terrain. The terrain's rows are split
+// into one band per ridge, y = 0 nearest; each ridge is its band's horizon
+// (Heightfield::rowMax()) seen from the front. Heights keep the terrain's
+// single normalization, so a peak that is tall in one band is tall in every
+// band it reaches. Renders like MountainLayer: fog, anti-aliasing and
+// front-to-back compositing all apply.
+class HeightfieldLayer : public MountainLayer {
+public:
+  // 'slices' are the ridges back to front; only their look is used (colors,
+  // fog, minHeight/maxHeight, verticalSpan, verticalOffset). Their width
+  // becomes the terrain's size and the shape fields are ignored. Bands are
+  // cut on 'pool' when given.
+  HeightfieldLayer(std::shared_ptr<const Heightfield> terrain,
+                   std::vector<MountainParams> slices,
+                   ThreadPool *pool = nullptr);
+
+  const Heightfield &terrain() const { return *terrain_; }
+
+private:
+  static std::vector<Mountain> cutSlices(const Heightfield &terrain,
+                                         std::vector<MountainParams> slices,
+                                         ThreadPool *pool);
+
+  std::shared_ptr<const Heightfield> terrain_;
+};
@@ -1,5 +1,6 @@
 // include/IRenderer.h
 #pragma once
+#include "PixelFormat.h"
 #include <cstdint>
 #include <vector>
 
@@ -8,7 +9,11 @@ struct Event {
     Quit,
     KeyDown,
     KeyUp,
-    MouseMove, // extend later if needed
+    MouseMove,
+    MouseDown, // code is the button (MouseButton), x and y where it went
+    MouseUp,
+    Resize,    // output size changed to x * y; frame memory is reallocated
+    Expose,    // the window lost its contents and needs present() again
     // ... add more event kinds as needed
   } type;
 
@@ -17,15 +22,62 @@ struct Event {
   // codes to actions.
   int code = 0;
 
-  // Mouse fields (unused for now)
+  // Mouse position, or the new width and height for Resize
   int x = 0, y = 0;
 };
 
+// App-level key codes for Event::code. Printable keys use their ASCII value,
+// which is also what SDL_Keycode uses for them, so the SDL backend passes
+// keysyms through unchanged and main() never has to include SDL.
+namespace Key {
+constexpr int Escape = 27;
+constexpr int Space = ' ';
+constexpr int Num0 = '0';
+constexpr int Num9 = '9';
+constexpr int A = 'a';
+constexpr int C = 'c';
+constexpr int E = 'e';
+constexpr int M = 'm';
+constexpr int N = 'n';
+constexpr int P = 'p';
+constexpr int Q = 'q';
+constexpr int R = 'r';
+constexpr int S = 's';
+constexpr int T = 't';
+} // namespace Key
+
+// Event::code of MouseDown/MouseUp, in SDL's button numbering.
+namespace MouseButton {
+constexpr int Left = 1;
+constexpr int Middle = 2;
+constexpr int Right = 3;
+} // namespace MouseButton
+
+// Writable frame memory handed out by IRenderer::beginFrame().
+struct FrameBuffer {
+  void *pixels = nullptr; // IRenderer::pixelFormat(); null if not lockable
+  int pitch = 0;          // bytes per row, may exceed width * pixel size
+};
+
 struct IRenderer {
   virtual ~IRenderer() = default;
+  // Ask for a texture format; takes effect at the next init(). Without a
+  // request the backend chooses.
+  virtual void requestPixelFormat(PixelFormat format) = 0;
   virtual bool init(int width, int height, const char *title) = 0;
-  // updateTexture expects pixels in ARGB8888 and pitch in bytes
-  virtual void updateTexture(const uint32_t *pixels, int pitch) = 0;
+  // Format of the texture: what updateTexture() expects and beginFrame()
+  // hands out. Valid after init().
+  virtual PixelFormat pixelFormat() const = 0;
+  // updateTexture expects pixels in pixelFormat() and pitch in bytes
+  virtual void updateTexture(const void *pixels, int pitch) = 0;
+
+  // Zero-copy alternative to updateTexture(): render straight into the
+  // backend's frame memory between beginFrame() and endFrame(). The contents
+  // are undefined on entry, so every pixel must be written. Call endFrame()
+  // only if beginFrame() returned pixels.
+  virtual FrameBuffer beginFrame() = 0;
+  virtual void endFrame() = 0;
+
   virtual void present() = 0;
 
   // Poll platform events and append them to 'outEvents'.
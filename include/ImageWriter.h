@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Write an ARGB8888 image as binary PPM (P6). Alpha is dropped.
+bool write_ppm(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride);
+
+// Encode an ARGB8888 image as an 8-bit RGB PNG. Rows use the Sub filter and
+// one fixed-Huffman deflate block whose only matches are byte runs (distance
+// 1). No search and no dynamic tables, but flat sky rows and solid ridge
+// fills filter to runs of zeros, so scene images still shrink by 50-100x.
+std::vector<uint8_t> encode_png(const uint32_t *pixels, int width, int height,
+                                int rowStride);
+bool write_png(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride);
+
+// Write an ARGB8888 image as packed little-endian 32-bit pixels, no header.
+bool write_raw(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride);
+
+// Pick the encoder from the file extension (".ppm", ".png", anything else
+// = raw).
+bool write_image(const std::string &path, const uint32_t *pixels, int width,
+                 int height, int rowStride);
@@ -1,15 +1,56 @@
 #pragma once
+#include "PixelFormat.h"
+#include <climits>
 #include <cstdint>
 
+class SpanRasterizer;
+
 struct RenderContext {
-  uint32_t *pixels;
+  void *pixels;  // rows of 'format' pixels
   int rowStride; // pixels per row
   int winW;
   int winH;
+  // Front-to-back compositing only: first already-final row per column. A
+  // layer writes rows above coverage[x] and lowers it to what it covered.
+  int16_t *coverage = nullptr;
+  // When set, rasterize row-major through this scratch instead of per column.
+  SpanRasterizer *raster = nullptr;
+  // Painter's order only: blend ridge edges by their sub-pixel coverage.
+  // Layers that cannot may ignore it and paint hard edges.
+  bool antiAlias = false;
+  // Only pixels in [clipX0, clipX1) x [clipY0, clipY1) may be written; the
+  // defaults cover the whole frame. Coverage values stay inside the clip.
+  int clipX0 = 0, clipY0 = 0;
+  int clipX1 = INT_MAX, clipY1 = INT_MAX;
+  // Layers compute colors in ARGB8888 and pack them to this format
+  // (PixelFormat.h); render_silhouette() and friends do that already.
+  PixelFormat format = PixelFormat::ARGB8888;
 };
 
 struct Layer {
   virtual ~Layer() = default;
   virtual void update(double dt) = 0;
   virtual void render(const RenderContext &ctx) = 0;
+  // Scenes may render in parallel bands: render() must stay inside the
+  // context's clip rectangle and may be called concurrently for disjoint
+  // clips (each with its own coverage and raster scratch).
+  //
+  // True if render() honours RenderContext::coverage. A scene with any layer
+  // returning false falls back to painter's-order compositing.
+  virtual bool supportsFrontToBack() const { return false; }
+  // The output is now winW x winH. Layers that precompute per-size data
+  // rebuild it here; render() contexts have the new size from then on.
+  virtual void resize(int /*winW*/, int /*winH*/) {}
+  // Called on the frame thread before the render()s of a frame; the place
+  // to refresh caches that concurrent band renders then only read.
+  virtual void prepare(int /*winW*/, int /*winH*/) {}
+
+  // Retained mode: a layer is dirty when its next render() may differ from
+  // the last one. Scene clears the flag after rendering.
+  bool isDirty() const { return dirty_; }
+  void markDirty() { dirty_ = true; }
+  void clearDirty() { dirty_ = false; }
+
+protected:
+  bool dirty_ = true;
 };
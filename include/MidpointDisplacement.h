@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+
+class ThreadPool;
+
+// Counter-based midpoint displacement.
+//
+// Instead of drawing from one sequential RNG, the offset of every midpoint is
+// a pure function of (key, level, index): level 0 is the single midpoint of
+// the whole span, level l has 2^l midpoints numbered left to right. Each level
+// is therefore an independent data-parallel loop, any sub-interval can be
+// regenerated on its own, and output is bit-identical for any thread count
+// and any platform with IEEE doubles (the library is built without FP
+// contraction).
+
+// SplitMix64 finalizer.
+inline uint64_t mix64(uint64_t z) noexcept {
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// Per-ridge stream key derived from a user seed.
+inline uint64_t midpoint_key(uint32_t seed) noexcept {
+  return mix64(uint64_t(seed) ^ 0x6A09E667F3BCC909ull);
+}
+
+// Seed stream for ridge 'index' of a scene built from one 'sceneSeed';
+// MountainParams::seed takes the high 32 bits.
+inline uint64_t ridge_seed(uint64_t sceneSeed, uint64_t index) noexcept {
+  return mix64(sceneSeed + (index + 1) * 0xBF58476D1CE4E5B9ull);
+}
+
+// Uniform value in [-1, 1) for midpoint 'index' of 'level'.
+inline double midpoint_random(uint64_t key, int level,
+                              uint64_t index) noexcept {
+  uint64_t h = mix64(key + uint64_t(level + 1) * 0xD1B54A32D192ED03ull +
+                     index * 0x9E3779B97F4A7C15ull);
+  return double(h >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+// Fill h[1..n-2] breadth-first from the preset endpoints h[0] and h[n-1].
+// n must be 2^k + 1. 'disp' is the level-0 displacement, multiplied by
+// 'roughness' per level. Without 'pool', or when called from inside one of
+// its tasks, runs serially.
+void midpoint_displace_levels(double *h, int n, uint64_t key, double disp,
+                              double roughness, ThreadPool *pool = nullptr);
+
+// Run levels [firstLevel, ...) for the level-'firstLevel' segments
+// [segBegin, segEnd) only; 'disp' is the displacement at 'firstLevel'. The
+// segment endpoints must already be set. Used to regenerate sub-intervals.
+void midpoint_displace_segments(double *h, int n, uint64_t key, int firstLevel,
+                                uint64_t segBegin, uint64_t segEnd,
+                                double disp, double roughness);
@@ -1,22 +1,174 @@
 #pragma once
 #include "Color.h"
+#include "HeightPyramid.h"
+#include "Layer.h"
 #include "MountainParams.h"
+#include "SpanRaster.h"
 #include <cstdint>
-#include <random>
+#include <memory>
 #include <vector>
 
+class RidgeGenerator;
+class ThreadPool;
+
 class Mountain {
 public:
   explicit Mountain(MountainParams params);
-  void generate();
+  // With generateNow = false the ridge is empty until generate() runs, so
+  // batches can construct serially and generate in parallel.
+  Mountain(MountainParams params, bool generateNow);
+  // 'pool', if set, may split the generation of a very wide ridge.
+  void generate(ThreadPool *pool = nullptr);
   void regenerate(uint32_t newSeed);
+  // Become the ridge Mountain(params, generateNow) would be, keeping this
+  // one's buffers: regenerating into a retired ridge of the same width
+  // reuses its samples, pyramid and silhouette storage instead of
+  // allocating them again.
+  void reset(MountainParams params, bool generateNow = true);
+  // Replace the parameters. Only changes to the ridge shape (width, seed,
+  // heights, displacement, roughness, algorithm) regenerate the samples.
+  void setParams(MountainParams params);
+  // Paint into ctx's clip rectangle, front to back when ctx.coverage is set
+  // and row-major when ctx.raster is set. ctx.antiAlias without coverage
+  // uses render_silhouette_aa(). 'tops' may pass precomputed
+  // columnTops() for the context size; otherwise the silhouette cache is
+  // used if it matches, else the tops are computed into scratch.
+  void render(const RenderContext &ctx, const int16_t *tops = nullptr) const;
   void paint(uint32_t *pixels, int rowStride, int winW, int winH) const;
+  // Front-to-back variant: per column, fill only rows [topY, coverage[x])
+  // and lower coverage[x] to topY. Rows below coverage[x] are already final.
+  void paintOccluded(uint32_t *pixels, int rowStride, int winW, int winH,
+                     int16_t *coverage) const;
+  // Row-major equivalents of paint()/paintOccluded(): same pixels, filled
+  // as horizontal spans with vector stores.
+  void paintSpans(uint32_t *pixels, int rowStride, int winW, int winH,
+                  SpanRasterizer &raster) const;
+  void paintOccludedSpans(uint32_t *pixels, int rowStride, int winW, int winH,
+                          int16_t *coverage, SpanRasterizer &raster) const;
+  // Silhouette row (first painted row) of every column, as paint() uses it.
+  // Windows narrower than the ridge take the highest sample under each
+  // column from the height pyramid, so any width costs O(winW). Random-access
+  // ridges (RidgeAlgorithm::FbmNoise) keep no samples and instead evaluate
+  // each column center, without the detail finer than a column.
+  void columnTops(int winW, int winH, int16_t *out) const;
+  // Sub-pixel ridge line for anti-aliasing: 2 * winW + 1 rows in 24.8 fixed
+  // point, alternating column boundary and column center (out[2x] is the
+  // left edge of column x, out[2x + 1] its center). Centers are the heights
+  // columnTops() rounds down; boundaries average the neighbouring centers.
+  void columnEdges(int winW, int winH, int32_t *out) const;
+  // Empty for random-access ridges.
+  const HeightPyramid &pyramid() const noexcept { return pyramid_; }
+  // Take generated samples from elsewhere (a scene file) instead of running
+  // generate(): 'storage' is a whole pyramid as HeightPyramid::attach()
+  // expects it, for max(3, params().width) samples, used in place.
+  void adoptPyramid(const double *storage, std::shared_ptr<const void> owner);
+  // Likewise for samples made elsewhere (a Heightfield horizon):
+  // max(3, params().width) heights in [0, 1].
+  void setSamples(std::vector<double> samples);
+
+  // Sculpting: raise or lower the ridge under column x of a winW x winH
+  // view so that its top there is row y. The midpoint sub-interval holding
+  // the column (at most 'radius' columns long) moves as a whole and its
+  // neighbours ramp back down, all regenerated from their original random
+  // streams, so the detail is kept (RidgeGenerator::sculpt()). The rest of
+  // the ridge keeps its samples and the pyramid is patched in place, so an
+  // edit costs O(radius samples + log width) however wide the ridge is.
+  // Only hashed midpoint ridges made by generate() can be sculpted; others
+  // return false. Edits last until the ridge regenerates.
+  bool sculpt(int x, int y, int winW, int winH, int radius);
+
+  // Morphing (RidgeMorpher): the ridge is drawn as its column heights
+  // blended toward those of 'target', a generated ridge of the same width,
+  // by a weight starting at 0. Only the columns of the cached size blend,
+  // so setMorphWeight() plus silhouette() cost O(winW) and update the
+  // silhouette cache in place without allocating. finishMorph() takes over
+  // the target's shape and seed; any other shape change cancels the morph.
+  // Copies of a morphing Mountain share the target. finishMorph() returns
+  // the target, which holds this ridge's old storage when nothing else
+  // shared it, for generating the next target into.
+  void beginMorph(std::shared_ptr<Mountain> target);
+  void setMorphWeight(double weight);
+  std::shared_ptr<Mountain> finishMorph();
+  bool morphing() const noexcept { return bool(morphTarget_); }
+
+  // columnTops() for winW x winH, cached until the size, the parameters or
+  // the samples change, so painting is a pure fill. Updates the cache: not
+  // safe to call concurrently on one Mountain (Scene calls it once per frame
+  // before rendering bands).
+  const int16_t *silhouette(int winW, int winH);
+  // The cached silhouette if it is for winW x winH, else null.
+  const int16_t *cachedSilhouette(int winW, int winH) const noexcept {
+    return winW == silW_ && winH == silH_ && !morphStale_ ? silhouette_.data()
+                                                          : nullptr;
+  }
+  // columnEdges() cached alongside the silhouette, or null.
+  const int32_t *cachedEdges(int winW, int winH) const noexcept {
+    return winW == silW_ && winH == silH_ && !morphStale_ ? edges_.data()
+                                                          : nullptr;
+  }
+  // mountain_row_colors() for winH cached alongside the silhouette; null
+  // when stale or when the ridge has no fog.
+  const uint32_t *cachedRowColors(int winW, int winH) const noexcept {
+    return winW == silW_ && winH == silH_ && !rowColors_.empty()
+               ? rowColors_.data()
+               : nullptr;
+  }
   const MountainParams &params() const noexcept { return params_; }
 
 private:
-  static void midpoint_displace(std::vector<double> &h, int left, int right,
-                                double disp, std::mt19937 &rng,
-                                double roughness);
+  int topRow(double sample, int winH) const noexcept;
+  int32_t edgeRow(double sample, int winH) const noexcept;
+  // Inverse of topRow(): the sample in [0, 1] whose top is row y.
+  double heightAtRow(int y, int winH) const noexcept;
+  void resampleHeights(int winW, std::vector<double> &out) const;
+  void resampleOwn(int winW, std::vector<double> &out) const;
+  void topsFromHeights(const double *heights, int winW, int winH,
+                       int16_t *out) const;
+  void edgesFromHeights(const double *heights, int winW, int winH,
+                        int32_t *out) const;
   MountainParams params_;
+  // Null for samples adopted from elsewhere.
+  std::shared_ptr<const RidgeGenerator> generator_;
+  double heightScale_ = 1.0; // generator_->generate()'s, for sculpt()
   std::vector<double> samples_;
+  HeightPyramid pyramid_;
+  std::vector<int16_t> silhouette_;
+  std::vector<int32_t> edges_;
+  std::vector<int16_t> interior_; // aa_interior_rows() of edges_
+  std::vector<uint32_t> rowColors_; // empty without fog
+  std::vector<double> columns_;     // heights silhouette_ was built from
+  int silW_ = 0, silH_ = 0; // size silhouette_ is for; 0 = stale
+  std::shared_ptr<Mountain> morphTarget_;
+  double morphWeight_ = 0.0;
+  std::vector<double> fromCols_, toCols_; // both shapes' columns at silW_
+  bool morphStale_ = false; // columns_ changed at the cached size
 };
+
+// Per-row colors of a fogged ridge (MountainParams::fogStrength), winH
+// entries, built with the 8.8 gradient kernel. Returns false, leaving 'out'
+// alone, when the ridge has no fog and is one flat color.
+bool mountain_row_colors(const MountainParams &params, int winH,
+                         uint32_t *out);
+
+// Fill the rows at and below tops[x] in every column of ctx's clip with one
+// color, or with rowColors[y] per row when given, honouring ctx.coverage and
+// ctx.raster like Mountain::render(). Colors are ARGB8888 and are packed to
+// ctx.format once per call.
+void render_silhouette(const RenderContext &ctx, const int16_t *tops,
+                       uint32_t color, const uint32_t *rowColors = nullptr);
+// Anti-aliased fill below a Mountain::columnEdges() line, painter's order
+// only (edge pixels blend over what is already there). Each column's edge
+// is two line segments, boundary to center to boundary; the pixels they
+// cross get their exact covered area, in 1/256ths, blended in 8.8 fixed
+// point (in 5-bit steps for RGB565). Rows fully below the line are plain
+// render_silhouette() fills, so the extra cost is the edge pixels, about one
+// per column on gentle slopes.
+// 'interior' may pass aa_interior_rows() of 'edges'; otherwise it is
+// computed into thread-local scratch.
+void render_silhouette_aa(const RenderContext &ctx, const int32_t *edges,
+                          uint32_t color, const uint32_t *rowColors = nullptr,
+                          const int16_t *interior = nullptr);
+// First row of columns [x0, x1) that lies wholly below a columnEdges() line
+// (the plain fill under render_silhouette_aa()'s edge pixels), into out[x].
+void aa_interior_rows(const int32_t *edges, int x0, int x1, int winH,
+                      int16_t *out);
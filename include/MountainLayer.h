@@ -1,6 +1,8 @@
 #pragma once
 #include "Layer.h"
 #include "Mountain.h"
+#include "RidgeMorpher.h"
+#include <memory>
 #include <vector>
 
 class MountainLayer : public Layer {
@@ -8,8 +10,16 @@ public:
   MountainLayer(std::vector<Mountain> mountains);
   void update(double dt) override;
   void render(const RenderContext &ctx) override;
-  std::vector<Mountain> &mountains() { return mountains_; }
+  bool supportsFrontToBack() const override { return true; }
+  void prepare(int winW, int winH) override;
+  // Keep morphing the ridges into new seeds, as Scene::setMorphing().
+  void setMorphing(double seconds);
+  std::vector<Mountain> &mountains() {
+    markDirty();
+    return mountains_;
+  }
 
 private:
   std::vector<Mountain> mountains_;
+  std::unique_ptr<RidgeMorpher> morpher_; // null unless morphing
 };
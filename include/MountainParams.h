@@ -3,6 +3,12 @@
 #include <cstdint>
 #include <string>
 
+enum class RidgeAlgorithm : uint8_t {
+  MidpointHashed,    // breadth-first, counter-based hash per midpoint
+  MidpointRecursive, // legacy depth-first walk over one std::mt19937 stream
+  FbmNoise,          // gradient-noise octaves, evaluated per column on demand
+};
+
 struct MountainParams {
   int width = 1024; // number of horizontal samples (usually window width)
   uint32_t seed = 12345u;
@@ -15,6 +21,12 @@ struct MountainParams {
   double verticalSpan = 0.75; // fraction of window height
   int verticalOffset = 0;
   uint32_t colorARGB = 0xFF1E1E1E; // default mountain color
+  // Atmospheric haze: rows fade from colorARGB at the ridge's highest
+  // possible top to colorARGB mixed fogStrength of the way toward fogColor
+  // at the bottom of the window. The ridge keeps colorARGB's alpha.
+  double fogStrength = 0.0;
+  uint32_t fogColor = 0xFFC8D0D8u;
+  RidgeAlgorithm algorithm = RidgeAlgorithm::MidpointHashed;
   std::string name;
 
   void validate() const {
@@ -22,5 +34,6 @@ struct MountainParams {
     assert(minHeight <= maxHeight);
     assert(verticalSpan > 0.0 && verticalSpan <= 1.0);
     assert(roughness > 0.0 && roughness < 1.5);
+    assert(fogStrength >= 0.0 && fogStrength <= 1.0);
   }
 };
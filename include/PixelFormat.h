@@ -0,0 +1,136 @@
+#pragma once
+#include "RenderUtils.h"
+#include <cstdint>
+#include <vector>
+
+// Output pixel formats. Colors are computed in ARGB8888 everywhere (ridge
+// and fog colors, sky rows, gradients) and packed to the output format once
+// per color or row; only the loops that touch every pixel, the fills and
+// the edge blends, are templates over PixelTraits, so each format gets its
+// own specialized code and no per-pixel format switch.
+enum class PixelFormat : uint8_t {
+  ARGB8888, // the default; what images are written in
+  XRGB8888, // 32-bit with the top byte ignored: blends skip alpha
+  RGB565,   // 16-bit: half the framebuffer bandwidth
+};
+
+constexpr int pixel_format_bytes(PixelFormat f) {
+  return f == PixelFormat::RGB565 ? 2 : 4;
+}
+
+inline const char *pixel_format_name(PixelFormat f) {
+  switch (f) {
+  case PixelFormat::XRGB8888:
+    return "xrgb8888";
+  case PixelFormat::RGB565:
+    return "rgb565";
+  case PixelFormat::ARGB8888:
+    break;
+  }
+  return "argb8888";
+}
+
+// Per-format pixel type and operations:
+//   pack(argb)         ARGB8888 color -> Pixel
+//   unpack(p)          Pixel -> ARGB8888, opaque if the format has no alpha
+//   blend_q8(d, s, a)  d + (s - d) * a / 256 for a in [0, 256]
+//   half(p)            color at half brightness
+// kNative is true when pack() is the identity, so ARGB8888 row colors can
+// be used as they are.
+template <PixelFormat F> struct PixelTraits;
+
+template <> struct PixelTraits<PixelFormat::ARGB8888> {
+  using Pixel = uint32_t;
+  static constexpr PixelFormat kFormat = PixelFormat::ARGB8888;
+  static constexpr bool kNative = true;
+  static Pixel pack(uint32_t argb) noexcept { return argb; }
+  static uint32_t unpack(Pixel p) noexcept { return p; }
+  static Pixel blend_q8(Pixel dst, Pixel src, uint32_t a) noexcept {
+    return blend_argb_q8(dst, src, a);
+  }
+  static Pixel half(Pixel p) noexcept {
+    return (p & 0xFF000000u) | ((p >> 1) & 0x007F7F7Fu);
+  }
+};
+
+// The top byte carries whatever the ARGB color had and is never read, so
+// blends do red/blue as one pair and green alone.
+template <> struct PixelTraits<PixelFormat::XRGB8888> {
+  using Pixel = uint32_t;
+  static constexpr PixelFormat kFormat = PixelFormat::XRGB8888;
+  static constexpr bool kNative = true;
+  static Pixel pack(uint32_t argb) noexcept { return argb; }
+  static uint32_t unpack(Pixel p) noexcept { return p | 0xFF000000u; }
+  static Pixel blend_q8(Pixel dst, Pixel src, uint32_t a) noexcept {
+    const uint32_t ia = 256 - a;
+    uint32_t rb = (((src & 0x00FF00FFu) * a + (dst & 0x00FF00FFu) * ia +
+                    0x00800080u) >>
+                   8) &
+                  0x00FF00FFu;
+    uint32_t g =
+        (((src & 0x0000FF00u) * a + (dst & 0x0000FF00u) * ia + 0x00008000u) >>
+         8) &
+        0x0000FF00u;
+    return rb | g;
+  }
+  static Pixel half(Pixel p) noexcept { return (p >> 1) & 0x007F7F7Fu; }
+};
+
+// 5:6:5 with the channels' top bits. Blends spread the pixel over 32 bits
+// as 00000GGGGGG00000RRRRR000000BBBBB, where each channel has five spare bits
+// above it, and weigh both pixels by a / 8 in [0, 32] in one multiply each.
+template <> struct PixelTraits<PixelFormat::RGB565> {
+  using Pixel = uint16_t;
+  static constexpr PixelFormat kFormat = PixelFormat::RGB565;
+  static constexpr bool kNative = false;
+  static Pixel pack(uint32_t argb) noexcept {
+    return Pixel(((argb >> 8) & 0xF800u) | ((argb >> 5) & 0x07E0u) |
+                 ((argb >> 3) & 0x001Fu));
+  }
+  static uint32_t unpack(Pixel p) noexcept {
+    uint32_t r = (p >> 11) & 0x1Fu, g = (p >> 5) & 0x3Fu, b = p & 0x1Fu;
+    return 0xFF000000u | (((r << 3) | (r >> 2)) << 16) |
+           (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+  }
+  static Pixel blend_q8(Pixel dst, Pixel src, uint32_t a) noexcept {
+    const uint32_t a5 = (a + 4) >> 3;
+    const uint32_t s = (src | (uint32_t(src) << 16)) & 0x07E0F81Fu;
+    const uint32_t d = (dst | (uint32_t(dst) << 16)) & 0x07E0F81Fu;
+    uint32_t m = ((s * a5 + d * (32 - a5) + 0x02008010u) >> 5) & 0x07E0F81Fu;
+    return Pixel(m | (m >> 16));
+  }
+  static Pixel half(Pixel p) noexcept { return Pixel((p >> 1) & 0x7BEFu); }
+};
+
+// Calls fn(PixelTraits<f>{}) with the traits of a format known only at run
+// time; fn is typically a generic lambda instantiated for every format.
+template <class Fn> decltype(auto) with_pixel_format(PixelFormat f, Fn &&fn) {
+  switch (f) {
+  case PixelFormat::XRGB8888:
+    return fn(PixelTraits<PixelFormat::XRGB8888>{});
+  case PixelFormat::RGB565:
+    return fn(PixelTraits<PixelFormat::RGB565>{});
+  case PixelFormat::ARGB8888:
+    break;
+  }
+  return fn(PixelTraits<PixelFormat::ARGB8888>{});
+}
+
+// rowColors[y] for y in [y0, y1), packed for format T and indexed by y like
+// the input. Native formats get 'rowColors' back; the others share one
+// thread-local buffer, valid until the next call for the same T on the same
+// thread.
+template <class T>
+const typename T::Pixel *pack_rows(const uint32_t *rowColors, int y0,
+                                   int y1) {
+  if constexpr (T::kNative) {
+    return rowColors;
+  } else {
+    thread_local std::vector<typename T::Pixel> rows;
+    if (rows.size() < size_t(y1))
+      rows.resize(size_t(y1));
+    for (int y = y0; y < y1; ++y)
+      rows[size_t(y)] = T::pack(rowColors[y]);
+    return rows.data();
+  }
+}
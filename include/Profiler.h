@@ -0,0 +1,120 @@
+#pragma once
+#include "PixelFormat.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// Per-frame profiling. Timers exist only in builds configured with
+// -DMOUNTAINS_PROFILE=ON; otherwise MOUNTAINS_PROFILE_SCOPE expands to
+// nothing and Profiler::kEnabled is false, so callers can guard the rest
+// with a plain if.
+#ifndef MOUNTAINS_PROFILE
+#define MOUNTAINS_PROFILE 0
+#endif
+
+enum class ProfileZone : uint8_t {
+  SceneUpdate,
+  SceneRender,
+  LayerRender,      // all Layer::render() calls of the frame
+  MountainPaint,    // all Mountain::render() calls, summed over threads
+  MountainGenerate, // ridge generation, including background builds
+  Upload,           // updateTexture() or beginFrame()/endFrame()
+  Present,
+  Count
+};
+
+const char *profile_zone_name(ProfileZone z);
+
+// Per-frame time of one zone over the recorded history, in milliseconds.
+struct ProfileStats {
+  double meanMs = 0.0;
+  double p50Ms = 0.0;
+  double p95Ms = 0.0;
+  double p99Ms = 0.0;
+  double callsPerFrame = 0.0;
+  int frames = 0;
+};
+
+class Profiler {
+public:
+  static constexpr bool kEnabled = MOUNTAINS_PROFILE != 0;
+  static constexpr int kZones = int(ProfileZone::Count);
+  static constexpr int kHistory = 256; // frames kept for the summaries
+
+  static Profiler &instance() {
+    static Profiler p;
+    return p;
+  }
+
+  // Add a timed interval to the open frame. Lock-free, any thread.
+  void record(ProfileZone z, uint64_t ns) noexcept {
+    openNs_[size_t(z)].fetch_add(ns, std::memory_order_relaxed);
+    openCalls_[size_t(z)].fetch_add(1, std::memory_order_relaxed);
+  }
+  // Close the open frame, whose work took 'frameNs', and move its totals
+  // into the history ring. Frame thread only.
+  void endFrame(uint64_t frameNs) noexcept;
+  uint64_t framesRecorded() const {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  // Summaries read the ring and are meant for the frame thread too.
+  // ProfileZone::Count selects whole-frame times.
+  ProfileStats stats(ProfileZone z) const;
+  // One line per zone: frames,zone,calls_per_frame,mean_ms,p50_ms,...
+  void writeCsv(std::FILE *f, bool header) const;
+  // One JSON object per call, keyed by zone name.
+  void writeJson(std::FILE *f) const;
+
+  // Overlay in the top-left corner: a graph of recent frame times (the
+  // grey line marks 60 Hz) above one bar per zone showing its p95 against a
+  // 60 Hz budget, in zone order and colored red, orange, yellow, green,
+  // cyan, blue, magenta.
+  void drawOverlay(void *pixels, int rowStride, int winW, int winH,
+                   PixelFormat format = PixelFormat::ARGB8888) const;
+
+private:
+  Profiler() = default;
+  template <class T>
+  void drawOverlayAs(typename T::Pixel *pixels, int rowStride, int winW,
+                     int winH) const;
+
+  struct Frame {
+    uint64_t ns[kZones + 1]; // per zone, then the whole frame
+    uint32_t calls[kZones];
+  };
+  std::array<std::atomic<uint64_t>, kZones> openNs_{};
+  std::array<std::atomic<uint32_t>, kZones> openCalls_{};
+  std::array<Frame, kHistory> ring_{};
+  std::atomic<uint64_t> head_{0}; // frames ever recorded
+};
+
+// Records the lifetime of the scope into a zone.
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileZone z) noexcept
+      : zone_(z), start_(std::chrono::steady_clock::now()) {}
+  ~ProfileScope() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start_)
+                  .count();
+    Profiler::instance().record(zone_, uint64_t(ns));
+  }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  ProfileZone zone_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#if MOUNTAINS_PROFILE
+#define MOUNTAINS_PROFILE_CAT2(a, b) a##b
+#define MOUNTAINS_PROFILE_CAT(a, b) MOUNTAINS_PROFILE_CAT2(a, b)
+#define MOUNTAINS_PROFILE_SCOPE(zone)                                         \
+  ProfileScope MOUNTAINS_PROFILE_CAT(profileScope_, __LINE__)(ProfileZone::zone)
+#else
+#define MOUNTAINS_PROFILE_SCOPE(zone) ((void)0)
+#endif
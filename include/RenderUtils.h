@@ -27,41 +27,48 @@ static inline double clampd(double v, double lo, double hi) noexcept {
   return v < lo ? lo : (v > hi ? hi : v);
 }
 
-static inline uint32_t modulate_color(uint32_t colorARGB,
-                                      double bright) noexcept {
-  int a, r, g, b;
-  unpackARGB(colorARGB, a, r, g, b);
-  r = int(clampd(r * bright, 0.0, 255.0));
-  g = int(clampd(g * bright, 0.0, 255.0));
-  b = int(clampd(b * bright, 0.0, 255.0));
-  return argb((uint8_t)a, (uint8_t)r, (uint8_t)g, (uint8_t)b);
+// Background fill for front-to-back compositing: rowColors[y] in the clip
+// [x0, x1) x [y0, ...), but only the rows above coverage[x] in each column.
+// Pixel is uint32_t or uint16_t, with row colors already in that format.
+template <class Pixel>
+static inline void fill_rows_occluded(Pixel *pixels, int rowStride, int x0,
+                                      int y0, int x1, const Pixel *rowColors,
+                                      const int16_t *coverage) {
+  int lowest = y0; // no column is uncovered at or below this row
+  for (int x = x0; x < x1; ++x)
+    lowest = std::max<int>(lowest, coverage[x]);
+  for (int y = y0; y < lowest; ++y) {
+    Pixel rowColor = rowColors[y];
+    Pixel *row = pixels + y * rowStride;
+    for (int x = x0; x < x1; ++x)
+      if (y < coverage[x])
+        row[x] = rowColor;
+  }
 }
 
-static inline void fill_sky_gradient(uint32_t *pixels, int rowStride, int winW,
-                                     int winH, uint32_t topColor,
-                                     uint32_t bottomColor) {
-  for (int y = 0; y < winH; ++y) {
-    double t = double(y) / double(std::max(1, winH - 1));
-    int a1 = (topColor >> 24) & 0xFF, r1 = (topColor >> 16) & 0xFF,
-        g1 = (topColor >> 8) & 0xFF, b1 = topColor & 0xFF;
-    int a2 = (bottomColor >> 24) & 0xFF, r2 = (bottomColor >> 16) & 0xFF,
-        g2 = (bottomColor >> 8) & 0xFF, b2 = bottomColor & 0xFF;
-    uint32_t a = uint32_t((1.0 - t) * a1 + t * a2 + 0.5);
-    uint32_t r = uint32_t((1.0 - t) * r1 + t * r2 + 0.5);
-    uint32_t g = uint32_t((1.0 - t) * g1 + t * g2 + 0.5);
-    uint32_t b = uint32_t((1.0 - t) * b1 + t * b2 + 0.5);
-    uint32_t rowColor = (a << 24) | (r << 16) | (g << 8) | b;
-    uint32_t *row = pixels + y * rowStride;
-    for (int x = 0; x < winW; ++x)
-      row[x] = rowColor;
-  }
+// dst + (src - dst) * a / 256 per channel, rounded, alpha included, for a
+// in [0, 256]. Red/blue and alpha/green go through the multiply as pairs; a
+// channel times 256 plus the rounding fits in its 16-bit lane, so the pairs
+// never carry.
+static inline uint32_t blend_argb_q8(uint32_t dst, uint32_t src,
+                                     uint32_t a) noexcept {
+  const uint32_t ia = 256 - a;
+  uint32_t rb = (((src & 0x00FF00FFu) * a + (dst & 0x00FF00FFu) * ia +
+                  0x00800080u) >>
+                 8) &
+                0x00FF00FFu;
+  uint32_t ag = (((src >> 8) & 0x00FF00FFu) * a +
+                 ((dst >> 8) & 0x00FF00FFu) * ia + 0x00800080u) &
+                0xFF00FF00u;
+  return rb | ag;
 }
 
 static inline int lerp_i(int a, int b, double t) noexcept {
   return int((1.0 - t) * a + t * b + 0.5);
 }
 
-// linear color lerp (t in [0,1]); returns ARGB
+// linear color lerp (t in [0,1]); returns ARGB. For deriving scheme colors;
+// per-pixel blends use blend_argb_q8() and the ColorKernels.h spans.
 static inline uint32_t lerpColor(uint32_t c1, uint32_t c2, double t) noexcept {
   int a1, r1, g1, b1, a2, r2, g2, b2;
   unpackARGB(c1, a1, r1, g1, b1);
@@ -71,12 +78,3 @@ static inline uint32_t lerpColor(uint32_t c1, uint32_t c2, double t) noexcept {
   return packARGB(a, r, g, b);
 }
 
-// brighten/darken by factor (>1 brightens, <1 darkens)
-static inline uint32_t scaleColor(uint32_t c, double factor) noexcept {
-  int a, r, g, b;
-  unpackARGB(c, a, r, g, b);
-  r = int(std::min(255.0, std::max(0.0, r * factor)));
-  g = int(std::min(255.0, std::max(0.0, g * factor)));
-  b = int(std::min(255.0, std::max(0.0, b * factor)));
-  return packARGB(a, r, g, b);
-}
@@ -0,0 +1,50 @@
+#pragma once
+#include "MountainParams.h"
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+// Turns a ridge's MountainParams into heights. Mountain owns one, made by
+// make_ridge_generator() from params.algorithm.
+//
+// Array engines (midpoint displacement) can only produce the whole ridge at
+// once. Random-access engines (fBm noise) can also produce any sample on its
+// own; Mountain then keeps no samples at all and evaluates just the columns
+// of the viewport, so very wide or zoomed-in ridges cost O(winW).
+class RidgeGenerator {
+public:
+  virtual ~RidgeGenerator() = default;
+
+  // All max(3, width) samples, normalized to [0, 1]. 'samples' is resized,
+  // keeping its capacity. Returns the factor raw heights were scaled by on
+  // the way, which sculpt() needs to displace in the same units. 'pool', if
+  // set, may split very wide ridges; the output does not depend on it.
+  virtual double generate(std::vector<double> &samples,
+                          ThreadPool *pool) const = 0;
+
+  // True if heightsAt() may be called.
+  virtual bool randomAccess() const { return false; }
+  // Normalized heights at fractional sample positions x[i] (0 is the left
+  // end; the ridge continues past both ends). Detail finer than 'footprint'
+  // samples is faded out, so columns each covering 'footprint' samples do not
+  // alias.
+  virtual void heightsAt(const double * /*x*/, int /*count*/,
+                         double /*footprint*/, double * /*out*/) const {}
+
+  // Sculpting, for engines whose midpoints are counter-based: raise or
+  // lower generate()'s 'samples' around sample 'at' until it is at
+  // 'height', by moving the ends of the lattice sub-interval holding it
+  // (at most 'radius' samples long) and regenerating that interval and its
+  // two neighbours from their own midpoint streams. 'scale' is what
+  // generate() returned. Sets [*first, *last] to the samples that may have
+  // changed and returns true, or returns false without touching 'samples'.
+  virtual bool sculpt(double * /*samples*/, int /*count*/, double /*scale*/,
+                      int /*at*/, double /*height*/, int /*radius*/,
+                      int * /*first*/, int * /*last*/) const {
+    return false;
+  }
+};
+
+std::shared_ptr<const RidgeGenerator>
+make_ridge_generator(const MountainParams &params);
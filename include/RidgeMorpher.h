@@ -0,0 +1,76 @@
+#pragma once
+#include "BackgroundWorker.h"
+#include "Mountain.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Ambient animation for a set of ridges: each keeps morphing from its shape
+// into the same ridge under a new seed, one morph per 'seconds' with an
+// eased weight, and then on into the next. The next set of targets is
+// generated on the BackgroundWorker while the current morph runs, into the
+// targets the morph before it finished with, so update() normally finds
+// them waiting. update() itself only hands targets over and moves the
+// weights (Mountain::setMorphWeight()): it never generates, blocks or, once
+// two sets of targets exist, allocates.
+class RidgeMorpher {
+public:
+  // 'seed' picks the sequence of target seeds.
+  RidgeMorpher(double seconds, uint64_t seed);
+  ~RidgeMorpher();
+  RidgeMorpher(const RidgeMorpher &) = delete;
+  RidgeMorpher &operator=(const RidgeMorpher &) = delete;
+
+  void setDuration(double seconds) { seconds_ = seconds; }
+  double duration() const { return seconds_; }
+  // Without looping, update() completes the running morph and starts no
+  // new one.
+  void setLooping(bool on) { looping_ = on; }
+  bool looping() const { return looping_; }
+  // True between morphs.
+  bool idle() const { return !morphing_; }
+
+  // Advance 'mountains' by dt seconds; true if any ridge changed shape.
+  // Targets made for a different set (another count or ridge shape) are
+  // dropped and requested again, so the caller may replace the mountains at
+  // any time.
+  bool update(std::vector<Mountain> &mountains, double dt);
+
+private:
+  using Targets = std::vector<std::shared_ptr<Mountain>>;
+  struct BuildJob final : BackgroundWorker::Job {
+    RidgeMorpher *owner = nullptr;
+    void run() override { owner->build(); }
+  };
+
+  void request(const std::vector<Mountain> &mountains);
+  bool requestedFor(const std::vector<Mountain> &mountains) const;
+  void build(); // on the worker
+
+  double seconds_;
+  uint64_t seed_;
+  uint64_t generation_ = 0; // target sets requested so far
+  double progress_ = 0.0;   // of the running morph, in [0, 1]
+  bool morphing_ = false;
+  bool looping_ = true;
+  bool requested_ = false; // a target set is being built or ready
+
+  // While building_ is set the worker owns pending_ and ready_; otherwise
+  // update() does.
+  std::vector<MountainParams> pending_; // the requested set
+  Targets ready_;                       // pending_'s targets, in order
+  Targets spare_; // targets of the last finished morph, reused next
+  std::atomic<bool> building_{false};
+  std::atomic<bool> cancelled_{false};
+  BuildJob job_;
+};
+
+// setMorphing(seconds) of Scene and MountainLayer: creates, retunes or winds
+// down the owner's morpher for 'mountains'.
+void set_morphing(std::unique_ptr<RidgeMorpher> &morpher, double seconds,
+                  const std::vector<Mountain> &mountains);
+// The owner's update(): advances the morpher, if any, and drops it once it
+// has wound down. True if any ridge changed shape.
+bool update_morphing(std::unique_ptr<RidgeMorpher> &morpher,
+                     std::vector<Mountain> &mountains, double dt);
@@ -10,9 +10,16 @@ public:
   ~SDLRenderer() override;
 
   // IRenderer interface
+  void requestPixelFormat(PixelFormat format) override;
+  // Without a requested format the texture matches the display: RGB565 on
+  // 16-bit displays, ARGB8888 otherwise.
   bool init(int width, int height, const char *title) override;
-  void updateTexture(const uint32_t *pixels,
+  PixelFormat pixelFormat() const override { return format_; }
+  void updateTexture(const void *pixels,
                      int pitch) override; // pitch in bytes
+  // Locks the streaming texture (SDL_LockTexture) for direct writes.
+  FrameBuffer beginFrame() override;
+  void endFrame() override;
   void present() override;
 
   // Poll platform events and append them to outEvents.
@@ -22,9 +29,15 @@ public:
   void cleanup() override;
 
 private:
+  bool createTexture(int width, int height);
+
   SDL_Window *win_ = nullptr;
   SDL_Renderer *ren_ = nullptr;
   SDL_Texture *tex_ = nullptr;
   int width_ = 0;
   int height_ = 0;
+  bool locked_ = false;
+  bool formatRequested_ = false;
+  PixelFormat requested_ = PixelFormat::ARGB8888;
+  PixelFormat format_ = PixelFormat::ARGB8888;
 };
@@ -0,0 +1,12 @@
+#pragma once
+
+// Batch kernels over height samples (doubles in [0, 1]). Like the color
+// kernels (ColorKernels.h), each picks AVX2, SSE2 or scalar code once at
+// first use. All three do the same double operations in the same order, so
+// results are bit-identical. 'dst' may equal 'a' or 'b'.
+
+// dst[i] = a[i] + (b[i] - a[i]) * t.
+void lerp_samples(double *dst, const double *a, const double *b, int count,
+                  double t);
+// Name of the kernel lerp_samples() dispatches to.
+const char *sample_kernels_isa();
@@ -1,11 +1,26 @@
 #pragma once
 #include "Mountain.h"
 #include "MountainLayer.h"
+#include "PixelFormat.h"
+#include "RidgeMorpher.h"
 #include "RenderUtils.h"
+#include "ThreadPool.h"
 #include <MountainColorScheme.h>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
+enum class CompositeMode : uint8_t {
+  Painter,     // sky, then layers and mountains back to front (overdraw)
+  FrontToBack, // nearest first with per-column coverage; one write per pixel
+};
+
+enum class RasterMode : uint8_t {
+  Columns, // per-column fills (strided writes)
+  Spans,   // per-row spans with vector stores; same pixels
+};
+
 class Scene {
 public:
   Scene(int width, int height, const MountainColorScheme &scheme);
@@ -14,17 +29,123 @@ public:
   void addLayer(std::unique_ptr<Layer> layer);
   void clearLayers();
   void update(double dt);
-  void render(uint32_t *pixels, int rowStride);
+  // Render into rows of 'format' pixels, 'rowStride' pixels apart.
+  void render(void *pixels, int rowStride,
+              PixelFormat format = PixelFormat::ARGB8888);
+  // Change the output size. Ridges are resampled from their height pyramids,
+  // never regenerated, so this is O(width) per ridge.
+  void resize(int width, int height);
+  int width() const { return width_; }
+  int height() const { return height_; }
   const MountainColorScheme &scheme() const { return scheme_; }
-  void setScheme(const MountainColorScheme &s) { scheme_ = s; }
+  void setScheme(const MountainColorScheme &s);
+  // Replace the mountains; ridges generate in parallel (buildMountains()).
   void setMountains(std::vector<MountainParams> paramsList);
+
+  // Batch progress: (ridges done, total). Return false to cancel.
+  using BuildProgress = std::function<bool(size_t done, size_t total)>;
+  // Generate all ridges on the scene's thread pool and replace the
+  // mountains. A nonzero 'sceneSeed' first sets ridge i's seed from
+  // ridge_seed(sceneSeed, i). Each ridge depends only on its own parameters,
+  // so the result is the same for any pool size. 'progress' runs after each
+  // ridge, never concurrently with itself; if it cancels, the mountains stay
+  // as they were and this returns false. Ridges regenerate into the spare
+  // mountains a recycle() left, if any, before new ones are made; spares
+  // beyond the new count are dropped.
+  bool buildMountains(std::vector<MountainParams> paramsList,
+                      uint64_t sceneSeed = 0,
+                      const BuildProgress &progress = {});
   void clearMountains(); // convenience
-  std::vector<Mountain> &getMountains() { return mountains_; }
+
+  // Take over a retired scene's storage: its mountains become spares whose
+  // buffers buildMountains() regenerates into, and its render scratch and
+  // frame cache replace this scene's empty ones. 'retired' is left empty
+  // and cheap to destroy. Rebuilding a scene of the same size and ridge
+  // count then allocates only the new parameters and generators.
+  void recycle(Scene &&retired);
+
+  // Scene files (SceneFile.h): the size, the scheme and every mountain's
+  // parameters, plus its height pyramid with 'withSamples'. Layers are not
+  // saved. load() maps the file and uses stored pyramids in place; ridges
+  // saved without samples regenerate on 'pool'.
+  bool save(const std::string &path, bool withSamples = true,
+            std::string *error = nullptr) const;
+  static std::unique_ptr<Scene> load(const std::string &path,
+                                     std::shared_ptr<ThreadPool> pool = {},
+                                     std::string *error = nullptr);
+  void setCompositeMode(CompositeMode m);
+  CompositeMode compositeMode() const { return composite_; }
+  void setRasterMode(RasterMode m);
+  RasterMode rasterMode() const { return raster_; }
+  // Anti-aliased ridge edges (see render_silhouette_aa()). Edge pixels blend
+  // over the ridges behind them, so while this is on the scene composites in
+  // painter's order whatever the composite mode says.
+  void setAntiAliasing(bool on);
+  bool antiAliasing() const { return antiAlias_; }
+  // Ambient animation: update() keeps morphing every mountain into the same
+  // ridge under a new seed, one morph per 'seconds' (RidgeMorpher). 0 lets
+  // the running morph finish and then stops.
+  void setMorphing(double seconds);
+  double morphing() const {
+    return morpher_ && morpher_->looping() ? morpher_->duration() : 0.0;
+  }
+  // Pointer sculpting (Mountain::sculpt()): the mountain drawn at pixel
+  // (x, y) or, over the sky, the one whose top in column x is nearest; -1
+  // if there is none.
+  int mountainAt(int x, int y) const;
+  // Move mountain 'index' so its top in column x is row y, with a brush
+  // 'radius' columns wide. False if it cannot be sculpted.
+  bool sculpt(int index, int x, int y, int radius);
+  // Mutable access assumes the caller changes something and marks the scene
+  // dirty.
+  std::vector<Mountain> &getMountains();
   const std::vector<Mountain> &getMountains() const { return mountains_; }
 
+  // Retained mode: true when the next render() would differ from the last
+  // one. A caller whose target buffer persists can skip render() and the
+  // texture upload while this is false.
+  bool isDirty() const;
+  void markDirty() { dirty_ = true; }
+  // Keep a copy of the last composited frame so a clean render() into any
+  // buffer is a copy instead of a re-render. Costs width*height pixels; a
+  // render() in another pixel format re-renders.
+  void setFrameCacheEnabled(bool on);
+
+  // Render in horizontal bands on this pool (null = single-threaded). The
+  // pool can be shared between scenes; output is identical either way.
+  void setThreadPool(std::shared_ptr<ThreadPool> pool);
+
 private:
   int width_, height_;
   MountainColorScheme scheme_;
   std::vector<Mountain> mountains_;
+  // A retired scene's ridges (recycle()), reused by the next
+  // buildMountains().
+  std::vector<Mountain> spareMountains_;
   std::vector<std::unique_ptr<Layer>> layers_;
+  CompositeMode composite_ = CompositeMode::Painter;
+  RasterMode raster_ = RasterMode::Columns;
+  bool antiAlias_ = false;
+  std::unique_ptr<RidgeMorpher> morpher_; // null unless morphing
+  std::vector<uint32_t> skyRows_; // sky color per row, cached per scheme
+  bool skyRowsValid_ = false;
+  std::shared_ptr<ThreadPool> pool_;
+
+  struct BandScratch {
+    SpanRasterizer raster;
+    std::vector<int16_t> coverage; // front-to-back, one per column
+    std::vector<int16_t> zeros;    // span-mode sky tops
+  };
+  std::vector<BandScratch> bandScratch_;
+  bool dirty_ = true;
+  bool frameCacheEnabled_ = false;
+  bool frameCacheValid_ = false;
+  PixelFormat frameCacheFormat_ = PixelFormat::ARGB8888;
+  std::vector<uint8_t> frameCache_;
+
+  void updateSkyRows();
+  void renderFrame(void *pixels, int rowStride, PixelFormat format);
+  void renderBand(void *pixels, int rowStride, PixelFormat format, int x0,
+                  int y0, int x1, int y1, bool frontToBack,
+                  BandScratch &scratch);
 };
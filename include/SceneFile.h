@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class Scene;
+class ThreadPool;
+
+// Binary scene files, version 1. Little-endian, every field fixed-width:
+//
+//   SceneFileHeader      64 bytes: magic, version, size, scheme, checksum
+//   SceneFileMountain    128 bytes per mountain, back to front
+//   names                the mountains' names, concatenated
+//   pyramids             optional; per mountain, 64-byte aligned, its whole
+//                        height pyramid (HeightPyramid::storage()) as doubles
+//
+// The checksum covers every byte after the header, and the pass that checks
+// it rejects pyramids holding NaN or infinity. With pyramids present a
+// load maps the file and points each mountain's pyramid straight at its
+// bytes: no parsing, no copies and no generation, so opening a large scene
+// costs what reading it from disk costs. Without them the ridges regenerate
+// from their parameters. Either way the doubles are bit-exact, so a shared
+// file looks the same on every machine. Only Scene's own mountains are
+// stored, not its layers.
+struct SceneFileHeader {
+  char magic[8]; // "MTNSCENE"
+  uint32_t version;
+  uint32_t flags; // kSceneFileHasPyramids
+  int32_t width, height;
+  uint32_t mountainCount;
+  uint32_t recordSize; // sizeof(SceneFileMountain)
+  uint64_t fileSize;
+  uint64_t checksum; // scene_file_checksum() of bytes [64, fileSize)
+  uint32_t skyTop, skyBottom, fogColor, sunColor;
+};
+
+struct SceneFileMountain {
+  double leftHeight, rightHeight, initialDisplacement, roughness;
+  double minHeight, maxHeight, verticalSpan, fogStrength;
+  int32_t width;
+  uint32_t seed;
+  int32_t verticalOffset;
+  uint32_t colorARGB, fogColor;
+  uint8_t algorithm;
+  uint8_t pad0[3];
+  uint32_t nameOffset, nameLength; // into the names block
+  uint64_t pyramidOffset; // from the start of the file; 0 = none
+  uint64_t pyramidCount;  // doubles
+  uint8_t pad2[16];
+};
+
+static_assert(sizeof(SceneFileHeader) == 64, "scene file header layout");
+static_assert(sizeof(SceneFileMountain) == 128, "scene file record layout");
+
+constexpr uint32_t kSceneFileVersion = 1;
+constexpr uint32_t kSceneFileHasPyramids = 1u;
+
+// Loads reject files beyond these, checksum or not: the frame size, one
+// ridge's width (which also bounds its pyramid), and the widths of all
+// ridges together, which is what generating them allocates.
+constexpr int32_t kSceneFileMaxSide = 1 << 14;
+constexpr int32_t kSceneFileMaxRidgeWidth = 1 << 24;
+constexpr uint64_t kSceneFileMaxSamples = uint64_t(1) << 26;
+
+// 64-bit hash with four independent multiply-rotate lanes, so checking a
+// mapped file runs at memory speed.
+uint64_t scene_file_checksum(const uint8_t *data, size_t size);
+
+// On failure these return false / null and describe why in 'error'.
+bool write_scene_file(const Scene &scene, const std::string &path,
+                      bool withPyramids, std::string *error = nullptr);
+// Ridges without stored pyramids generate on 'pool' (null = serially).
+std::unique_ptr<Scene> read_scene_file(const std::string &path,
+                                       std::shared_ptr<ThreadPool> pool = {},
+                                       std::string *error = nullptr);
@@ -0,0 +1,40 @@
+#pragma once
+#include "MountainParams.h"
+#include <MountainColorScheme.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+MountainColorScheme getNordScheme();
+MountainColorScheme getEverforestScheme();
+
+extern const std::vector<uint32_t> NORD_PALETTE;
+extern const std::vector<uint32_t> EVER_PALETTE;
+
+// Parameters for 'count' random ridges, back to front, colored from
+// 'palette' (random greys if it is empty). Everything is derived from
+// 'sceneSeed' (ridge i's seed is the high half of ridge_seed(sceneSeed, i)),
+// so one seed reproduces the same scene on any thread or machine.
+std::vector<MountainParams>
+makeRandomMountainsWithPalette(size_t count, int winW,
+                               const std::vector<uint32_t> &palette,
+                               const MountainColorScheme &scheme,
+                               uint64_t sceneSeed);
+std::vector<MountainParams>
+makeRandomMountainsNord(size_t count, int winW,
+                        const MountainColorScheme &scheme, uint64_t sceneSeed);
+std::vector<MountainParams>
+makeRandomMountainsEverforest(size_t count, int winW,
+                              const MountainColorScheme &scheme,
+                              uint64_t sceneSeed);
+
+// Shape of a random Heightfield at least 'size' samples on a side, from
+// 'sceneSeed'.
+MountainParams makeRandomTerrain(int size, uint64_t sceneSeed);
+// Looks for 'count' HeightfieldLayer slices, back to front, colored from
+// 'palette' like makeRandomMountainsWithPalette(). Slices are placed in
+// perspective: farther bands sit higher on screen and are scaled down, so
+// the terrain keeps its proportions from front to back.
+std::vector<MountainParams>
+makeTerrainSlices(size_t count, const std::vector<uint32_t> &palette,
+                  const MountainColorScheme &scheme);
@@ -0,0 +1,43 @@
+#pragma once
+#include "ChunkedRidge.h"
+#include "Layer.h"
+#include <vector>
+
+// Endless side-scrolling ridges. The layer's ridges (back to front) share
+// one scroll speed, so stacking several layers with increasing speeds gives
+// parallax. Ridges stream in chunks through ChunkedRidge's bounded cache and
+// silhouettes are recomputed in update() only when the view has moved by a
+// whole sample, so render() is the same flat fill as a static Mountain.
+class ScrollingMountainLayer : public Layer {
+public:
+  // 'speed' is in ridge samples per second (params.width samples span the
+  // window). winW x winH is the size render() will be called with until the
+  // next resize(); other sizes are drawn by resampling.
+  ScrollingMountainLayer(std::vector<MountainParams> ridges, double speed,
+                         int winW, int winH, int chunkLevels = 9);
+  void update(double dt) override;
+  void render(const RenderContext &ctx) override;
+  bool supportsFrontToBack() const override { return true; }
+  void resize(int winW, int winH) override;
+
+  void setSpeed(double speed) { speed_ = speed; }
+  double speed() const { return speed_; }
+  // Scroll position in samples; the window's left edge shows this sample.
+  void setPosition(double position);
+  double position() const { return position_; }
+  const std::vector<ChunkedRidge> &ridges() const { return ridges_; }
+
+private:
+  void refreshTops();
+  void refreshRowColors();
+
+  std::vector<ChunkedRidge> ridges_;
+  double speed_;
+  double position_ = 0.0;
+  int64_t topsFirst_ = 0; // world sample at column 0 of tops_
+  int winW_, winH_;
+  std::vector<int16_t> tops_; // winW_ per ridge
+  // winH_ fog row colors per ridge; fogged_[i] is false for flat ridges.
+  std::vector<uint32_t> rowColors_;
+  std::vector<bool> fogged_;
+};
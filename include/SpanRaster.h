@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Fill 'count' pixels starting at 'dst' with 'value'. Uses AVX2 or SSE2
+// stores when the CPU has them (picked once at first use). The 16-bit
+// overload is for RGB565 output.
+void fill_span(uint32_t *dst, int count, uint32_t value);
+void fill_span(uint16_t *dst, int count, uint16_t value);
+// Name of the kernel fill_span dispatches to: "avx2", "sse2" or "scalar".
+const char *fill_span_isa();
+
+struct RowSpan {
+  int16_t x0, x1; // [x0, x1)
+};
+
+// Row-major rasterizer for column-interval shapes. build() turns the region
+// { (x, y) : tops[x] <= y < bottoms[x] } into horizontal spans per row, so
+// fills walk memory in order instead of striding a whole row per pixel.
+// Holds its scratch between calls; one instance per thread.
+class SpanRasterizer {
+public:
+  // 'bottoms' may be null, meaning every column extends to winH. The region
+  // is clipped to columns [x0, x1) and rows [y0, y1).
+  void build(const int16_t *tops, const int16_t *bottoms, int winW, int winH);
+  void build(const int16_t *tops, const int16_t *bottoms, int winW, int winH,
+             int x0, int y0, int x1, int y1);
+
+  // Fill the built region with one color, or with rowColors[y] per row, in
+  // 32- or 16-bit pixels.
+  void fill(uint32_t *pixels, int rowStride, uint32_t color) const;
+  void fill(uint32_t *pixels, int rowStride, const uint32_t *rowColors) const;
+  void fill(uint16_t *pixels, int rowStride, uint16_t color) const;
+  void fill(uint16_t *pixels, int rowStride, const uint16_t *rowColors) const;
+
+  // Rows [firstRow(), endRow()) may contain spans; all others are empty.
+  int firstRow() const { return firstRow_; }
+  int endRow() const { return endRow_; }
+  // Spans of row y, for firstRow() <= y < endRow().
+  const RowSpan *rowBegin(int y) const;
+  const RowSpan *rowEnd(int y) const;
+
+  // Per-column scratch callers can fill with tops before build().
+  int16_t *columnScratch(int winW);
+
+private:
+  void emitRow();
+
+  std::vector<uint32_t> eventStart_; // per clip row offset into eventCols_
+  std::vector<int16_t> eventCols_;   // columns toggling on each row
+  std::vector<uint64_t> active_;     // one bit per column
+  std::vector<RowSpan> spans_;
+  std::vector<uint32_t> rowStart_; // per stored row offset into spans_
+  std::vector<int16_t> scratch_;
+  int winW_ = 0;
+  int firstRow_ = 0;
+  int lastEventRow_ = 0; // rows past this repeat its spans
+  int endRow_ = 0;
+};
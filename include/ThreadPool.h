@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Persistent fork-join pool. parallelFor() deals the index range out as one
+// contiguous block per participant (the workers plus the calling thread);
+// each takes indices from the front of its own block and, once that is empty,
+// steals from the back of someone else's. Blocks are lock-free packed
+// [begin, end) pairs, so stealing costs one CAS.
+class ThreadPool {
+public:
+  // 'workers' helper threads in addition to the caller (0 = hardware
+  // concurrency - 1).
+  explicit ThreadPool(int workers = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Threads taking part in parallelFor(), including the caller.
+  int concurrency() const { return int(threads_.size()) + 1; }
+
+  // Run fn(i) for every i in [0, count) and return when all are done.
+  // Calls from inside a task, or while another thread is inside
+  // parallelFor() on this pool, run serially on the calling thread.
+  template <class Fn> void parallelFor(int count, Fn &&fn) {
+    using F = std::remove_reference_t<Fn>;
+    run(count, Task{[](void *f, int i) { (*static_cast<F *>(f))(i); },
+                    const_cast<void *>(static_cast<const void *>(&fn))});
+  }
+
+private:
+  // Type-erased, non-owning callable; avoids a std::function allocation.
+  struct Task {
+    void (*call)(void *, int);
+    void *fn;
+    void operator()(int i) const { call(fn, i); }
+  };
+
+  void run(int count, const Task &task);
+  struct alignas(64) Block {
+    std::atomic<uint64_t> range{0}; // begin << 32 | end
+  };
+
+  void workerLoop(int slot);
+  void drain(int slot, const Task &task);
+  bool popFront(int slot, int &index);
+  bool stealBack(int slot, int &index);
+
+  std::vector<std::thread> threads_;
+  std::unique_ptr<Block[]> blocks_;
+  std::mutex runMutex_; // one parallelFor at a time
+
+  std::mutex m_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_ = 0;
+  int busyWorkers_ = 0;
+  bool stop_ = false;
+
+  const Task *task_ = nullptr; // guarded by m_
+  std::atomic<int> remaining_{0};
+};
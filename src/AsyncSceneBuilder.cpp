@@ -0,0 +1,77 @@
+#include "AsyncSceneBuilder.h"
+
+AsyncSceneBuilder::AsyncSceneBuilder()
+    : worker_(&AsyncSceneBuilder::workerLoop, this) {}
+
+AsyncSceneBuilder::~AsyncSceneBuilder() {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+    pending_ = nullptr;
+  }
+  latest_.fetch_add(1, std::memory_order_acq_rel); // cancel the running job
+  cv_.notify_all();
+  worker_.join();
+}
+
+void AsyncSceneBuilder::submit(Job job) {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    pending_ = std::move(job);
+    latest_.fetch_add(1, std::memory_order_acq_rel);
+  }
+  cv_.notify_all();
+}
+
+std::unique_ptr<Scene> AsyncSceneBuilder::takeReady() {
+  std::lock_guard<std::mutex> lk(m_);
+  return std::move(ready_);
+}
+
+void AsyncSceneBuilder::retire(std::unique_ptr<Scene> scene) {
+  std::lock_guard<std::mutex> lk(m_);
+  // An earlier scene still here was normally emptied by a job's recycle(),
+  // so freeing it (after the lock is released) is cheap.
+  std::swap(retired_, scene);
+}
+
+bool AsyncSceneBuilder::busy() const {
+  std::lock_guard<std::mutex> lk(m_);
+  return running_ || pending_ != nullptr;
+}
+
+void AsyncSceneBuilder::workerLoop() {
+  for (;;) {
+    Job job;
+    std::unique_ptr<Scene> retired;
+    uint64_t ticket;
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      cv_.wait(lk, [&] { return stop_ || pending_ != nullptr; });
+      if (stop_)
+        return;
+      job = std::move(pending_);
+      pending_ = nullptr;
+      retired = std::move(retired_);
+      ticket = latest_.load(std::memory_order_acquire);
+      running_ = true;
+    }
+
+    CancelCheck cancelled = [this, ticket] {
+      return latest_.load(std::memory_order_acquire) != ticket;
+    };
+    std::unique_ptr<Scene> scene = job(retired.get(), cancelled);
+
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      running_ = false;
+      // A newer request supersedes this result even if the job finished.
+      if (scene && !cancelled())
+        ready_ = std::move(scene);
+      // A job cancelled before recycling leaves the storage for the next.
+      if (!retired_)
+        retired_ = std::move(retired);
+    }
+    // A discarded scene is freed here, outside the lock.
+  }
+}
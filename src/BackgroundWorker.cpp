@@ -0,0 +1,68 @@
+#include "BackgroundWorker.h"
+
+BackgroundWorker &BackgroundWorker::instance() {
+  static BackgroundWorker worker;
+  return worker;
+}
+
+BackgroundWorker::BackgroundWorker()
+    : worker_(&BackgroundWorker::workerLoop, this) {}
+
+BackgroundWorker::~BackgroundWorker() {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  worker_.join();
+}
+
+void BackgroundWorker::post(Job &job) {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    if (job.queued_)
+      return;
+    job.queued_ = true;
+    job.next_ = nullptr;
+    if (tail_)
+      tail_->next_ = &job;
+    else
+      head_ = &job;
+    tail_ = &job;
+  }
+  wake_.notify_one();
+}
+
+void BackgroundWorker::cancel(Job &job) {
+  std::unique_lock<std::mutex> lk(m_);
+  if (job.queued_) {
+    Job *prev = nullptr;
+    for (Job *j = head_; j != &job; j = j->next_)
+      prev = j;
+    (prev ? prev->next_ : head_) = job.next_;
+    if (tail_ == &job)
+      tail_ = prev;
+    job.queued_ = false;
+  }
+  done_.wait(lk, [&] { return running_ != &job; });
+}
+
+void BackgroundWorker::workerLoop() {
+  std::unique_lock<std::mutex> lk(m_);
+  for (;;) {
+    wake_.wait(lk, [&] { return stop_ || head_; });
+    if (stop_)
+      return;
+    Job *job = head_;
+    head_ = job->next_;
+    if (!head_)
+      tail_ = nullptr;
+    job->queued_ = false;
+    running_ = job;
+    lk.unlock();
+    job->run();
+    lk.lock();
+    running_ = nullptr;
+    done_.notify_all();
+  }
+}
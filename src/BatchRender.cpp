@@ -0,0 +1,125 @@
+#include "BatchRender.h"
+#include "BoundedQueue.h"
+#include "ImageWriter.h"
+#include "Scene.h"
+#include "ScenePresets.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BatchItem {
+  uint64_t seed = 0;
+  std::unique_ptr<Scene> scene; // generated, then released after render
+  std::vector<uint32_t> pixels; // rendered frame
+};
+
+// Runs 'count' copies of a stage; the last one to finish closes 'out' (if
+// any) so the next stage drains and stops.
+template <class Fn>
+void startStage(std::vector<std::thread> &threads, int count,
+                BoundedQueue<BatchItem> *out, Fn fn) {
+  auto live = std::make_shared<std::atomic<int>>(count);
+  for (int i = 0; i < count; ++i)
+    threads.emplace_back([fn, live, out] {
+      fn();
+      if (live->fetch_sub(1) == 1 && out)
+        out->close();
+    });
+}
+
+} // namespace
+
+BatchStats render_batch(const BatchOptions &opts) {
+  BatchStats stats;
+  if (opts.lastSeed < opts.firstSeed || opts.width < 2 || opts.height < 2)
+    return stats;
+  std::error_code ec;
+  std::filesystem::create_directories(opts.outDir, ec);
+
+  MountainColorScheme scheme;
+  std::vector<uint32_t> palette;
+  if (opts.palette == BatchPalette::Nord) {
+    scheme = getNordScheme();
+    palette = NORD_PALETTE;
+  } else if (opts.palette == BatchPalette::Everforest) {
+    scheme = getEverforestScheme();
+    palette = EVER_PALETTE;
+  }
+
+  const int threads =
+      opts.threads > 0
+          ? opts.threads
+          : int(std::max(1u, std::thread::hardware_concurrency()));
+  BoundedQueue<BatchItem> generated(size_t(threads) * 2);
+  BoundedQueue<BatchItem> rendered(size_t(threads) * 2);
+
+  const uint64_t lastIndex = opts.lastSeed - opts.firstSeed;
+  std::atomic<uint64_t> nextIndex{0};
+  std::atomic<uint64_t> written{0};
+  std::mutex failMutex;
+  const int w = opts.width, h = opts.height;
+
+  auto t0 = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+
+  startStage(workers, threads, &generated, [&] {
+    for (;;) {
+      uint64_t i = nextIndex.fetch_add(1);
+      if (i > lastIndex)
+        return;
+      const uint64_t seed = opts.firstSeed + i;
+      BatchItem item;
+      item.seed = seed;
+      item.scene = std::make_unique<Scene>(w, h, scheme);
+      item.scene->setCompositeMode(CompositeMode::FrontToBack);
+      item.scene->setRasterMode(RasterMode::Spans);
+      item.scene->setAntiAliasing(opts.antiAlias);
+      item.scene->buildMountains(makeRandomMountainsWithPalette(
+          opts.mountains, w, palette, scheme, seed));
+      if (!generated.push(std::move(item)))
+        return;
+    }
+  });
+
+  startStage(workers, threads, &rendered, [&] {
+    BatchItem item;
+    while (generated.pop(item)) {
+      item.pixels.resize(size_t(w) * size_t(h));
+      item.scene->render(item.pixels.data(), w);
+      item.scene.reset();
+      if (!rendered.push(std::move(item)))
+        return;
+    }
+  });
+
+  startStage(workers, threads, nullptr, [&] {
+    BatchItem item;
+    while (rendered.pop(item)) {
+      std::string path = opts.outDir + "/mountains_" +
+                         std::to_string(item.seed) + "." + opts.format;
+      if (write_image(path, item.pixels.data(), w, h, w)) {
+        written.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(failMutex);
+      if (stats.failed++ == 0)
+        stats.firstFailure = path;
+    }
+  });
+
+  for (auto &t : workers)
+    t.join();
+  stats.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count();
+  stats.images = written.load();
+  return stats;
+}
@@ -0,0 +1,105 @@
+#include "ChunkedRidge.h"
+#include "MidpointDisplacement.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+int64_t floorDiv(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+} // namespace
+
+ChunkedRidge::ChunkedRidge(MountainParams params, int chunkLevels,
+                           int cacheChunks)
+    : params_(std::move(params)), levels_(std::clamp(chunkLevels, 1, 20)),
+      span_(1 << levels_) {
+  params_.validate();
+  key_ = midpoint_key(params_.seed);
+  boundaryKey_ = mix64(key_ ^ 0xBB67AE8584CAA73Bull);
+  center_ = 0.5 * (params_.leftHeight + params_.rightHeight);
+  amplitude_ = 0.5 * params_.initialDisplacement;
+  disp_ = 0.5 * params_.initialDisplacement;
+
+  // Fixed mapping to [0, 1]: 2.5 standard deviations of a sample around the
+  // center (uniform offsets of half-width d have variance d^2 / 3); the rare
+  // samples beyond are clamped.
+  double var = amplitude_ * amplitude_ / 3.0;
+  double d = disp_;
+  for (int l = 0; l < levels_; ++l, d *= params_.roughness)
+    var += d * d / 3.0;
+  double bound = 2.5 * std::sqrt(var);
+  if (bound <= 0.0)
+    bound = 1.0;
+  lo_ = center_ - bound;
+  scale_ = 0.5 / bound;
+
+  cache_.resize(size_t(std::max(2, cacheChunks)));
+}
+
+double ChunkedRidge::boundary(int64_t i) const noexcept {
+  return center_ + amplitude_ * midpoint_random(boundaryKey_, 0, uint64_t(i));
+}
+
+const double *ChunkedRidge::chunk(int64_t index) {
+  Chunk *victim = &cache_.front();
+  for (Chunk &c : cache_) {
+    if (c.lastUse != 0 && c.index == index) {
+      c.lastUse = ++useClock_;
+      return c.h.data();
+    }
+    if (c.lastUse < victim->lastUse)
+      victim = &c;
+  }
+
+  MOUNTAINS_PROFILE_SCOPE(MountainGenerate);
+  const int n = span_ + 1;
+  victim->index = index;
+  victim->lastUse = ++useClock_;
+  victim->h.resize(size_t(n));
+  double *h = victim->h.data();
+  h[0] = boundary(index);
+  h[n - 1] = boundary(index + 1);
+  uint64_t chunkKey = mix64(key_ + uint64_t(index) * 0xD6E8FEB86659FD93ull);
+  midpoint_displace_levels(h, n, chunkKey, disp_, params_.roughness);
+  ++generated_;
+  return h;
+}
+
+void ChunkedRidge::sample(int64_t first, int count, double *out) {
+  int i = 0;
+  while (i < count) {
+    int64_t w = first + i;
+    int64_t c = floorDiv(w, span_);
+    int local = int(w - c * span_);
+    int run = std::min(count - i, span_ - local);
+    const double *h = chunk(c) + local;
+    for (int k = 0; k < run; ++k)
+      out[i + k] = std::clamp((h[k] - lo_) * scale_, 0.0, 1.0);
+    i += run;
+  }
+}
+
+void ChunkedRidge::columnTops(int64_t first, int winW, int winH,
+                              int16_t *out) {
+  const int sampW = params_.width;
+  const double hRange = params_.maxHeight - params_.minHeight;
+  int64_t cachedChunk = 0;
+  const double *h = nullptr;
+  for (int x = 0; x < winW; ++x) {
+    int64_t w = first + (sampW == winW ? x
+                                       : int64_t((double(x) / double(winW)) *
+                                                 sampW));
+    int64_t c = floorDiv(w, span_);
+    if (!h || c != cachedChunk) {
+      h = chunk(c);
+      cachedChunk = c;
+    }
+    double s = std::clamp((h[w - c * span_] - lo_) * scale_, 0.0, 1.0);
+    double scaled = (params_.minHeight + s * hRange) * params_.verticalSpan;
+    int topY =
+        static_cast<int>((1.0 - scaled) * double(winH)) - params_.verticalOffset;
+    out[x] = static_cast<int16_t>(std::clamp(topY, 0, winH - 1));
+  }
+}
@@ -0,0 +1,296 @@
+#include "ColorKernels.h"
+#include "CpuFeatures.h"
+#include "PixelFormat.h"
+#include "RenderUtils.h"
+#include "SpanRaster.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define MOUNTAINS_X86 1
+#endif
+
+#if defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MOUNTAINS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MOUNTAINS_TARGET(isa)
+#endif
+
+namespace {
+
+uint32_t scalePixel(uint32_t c, uint32_t factor) {
+  uint32_t out = c & 0xFF000000u;
+  for (int shift = 0; shift <= 16; shift += 8)
+    out |= std::min<uint32_t>(255, (((c >> shift) & 0xFF) * factor) >> 8)
+           << shift;
+  return out;
+}
+
+uint32_t overPixel(uint32_t d, uint32_t s) {
+  uint32_t a = s >> 24;
+  a += a >> 7;
+  return (blend_argb_q8(d, s, a) & 0x00FFFFFFu) | (d & 0xFF000000u);
+}
+
+void lerpScalar(uint32_t *dst, const uint32_t *src, int count, uint32_t color,
+                uint32_t t) {
+  for (int i = 0; i < count; ++i)
+    dst[i] = blend_argb_q8(src[i], color, t);
+}
+
+void scaleScalar(uint32_t *dst, const uint32_t *src, int count,
+                 uint32_t factor) {
+  for (int i = 0; i < count; ++i)
+    dst[i] = scalePixel(src[i], factor);
+}
+
+void overScalar(uint32_t *dst, const uint32_t *src, int count) {
+  for (int i = 0; i < count; ++i)
+    dst[i] = overPixel(dst[i], src[i]);
+}
+
+#ifdef MOUNTAINS_X86
+// Pixels widen to one 16-bit lane per channel. A channel times a weight of
+// at most 256, plus the other term and the rounding, stays below 65536, so
+// 16-bit multiplies are exact and a logical shift divides by 256.
+
+MOUNTAINS_TARGET("sse2")
+__m128i lerp4(__m128i v, __m128i wt, __m128i cterm) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+  lo = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, wt), cterm), 8);
+  hi = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, wt), cterm), 8);
+  return _mm_packus_epi16(lo, hi);
+}
+
+MOUNTAINS_TARGET("sse2")
+void lerpSse2(uint32_t *dst, const uint32_t *src, int count, uint32_t color,
+              uint32_t t) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wt = _mm_set1_epi16(short(256 - t));
+  const __m128i c = _mm_unpacklo_epi8(_mm_set1_epi32(int(color)), zero);
+  const __m128i cterm = _mm_add_epi16(
+      _mm_mullo_epi16(c, _mm_set1_epi16(short(t))), _mm_set1_epi16(128));
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     lerp4(v, wt, cterm));
+  }
+  lerpScalar(dst + i, src + i, count - i, color, t);
+}
+
+MOUNTAINS_TARGET("sse2")
+__m128i scale4(__m128i v, __m128i f, __m128i alphaMask) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i c255 = _mm_set1_epi16(255);
+  __m128i lo = _mm_slli_epi16(_mm_unpacklo_epi8(v, zero), 8);
+  __m128i hi = _mm_slli_epi16(_mm_unpackhi_epi8(v, zero), 8);
+  // (x << 8) * f >> 16 == x * f >> 8; then min(., 255) without SSE4.1.
+  lo = _mm_mulhi_epu16(lo, f);
+  hi = _mm_mulhi_epu16(hi, f);
+  lo = _mm_sub_epi16(lo, _mm_subs_epu16(lo, c255));
+  hi = _mm_sub_epi16(hi, _mm_subs_epu16(hi, c255));
+  __m128i out = _mm_packus_epi16(lo, hi);
+  return _mm_or_si128(_mm_andnot_si128(alphaMask, out),
+                      _mm_and_si128(alphaMask, v));
+}
+
+MOUNTAINS_TARGET("sse2")
+void scaleSse2(uint32_t *dst, const uint32_t *src, int count,
+               uint32_t factor) {
+  const __m128i f = _mm_set1_epi16(short(uint16_t(factor)));
+  const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000u));
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     scale4(v, f, alphaMask));
+  }
+  scaleScalar(dst + i, src + i, count - i, factor);
+}
+
+MOUNTAINS_TARGET("sse2")
+__m128i overHalf(__m128i s, __m128i d) {
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+  a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+  __m128i ia = _mm_sub_epi16(_mm_set1_epi16(256), a);
+  __m128i sum = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, ia));
+  return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+MOUNTAINS_TARGET("sse2")
+void overSse2(uint32_t *dst, const uint32_t *src, int count) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alphaMask = _mm_set1_epi32(int(0xFF000000u));
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+    __m128i lo =
+        overHalf(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+    __m128i hi =
+        overHalf(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+    __m128i out = _mm_packus_epi16(lo, hi);
+    out = _mm_or_si128(_mm_andnot_si128(alphaMask, out),
+                       _mm_and_si128(alphaMask, d));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), out);
+  }
+  overScalar(dst + i, src + i, count - i);
+}
+
+// The AVX2 kernels are the SSE2 ones eight pixels wide. Unpack and pack both
+// work within 128-bit lanes, so pixel order survives the round trip.
+
+MOUNTAINS_TARGET("avx2")
+void lerpAvx2(uint32_t *dst, const uint32_t *src, int count, uint32_t color,
+              uint32_t t) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i wt = _mm256_set1_epi16(short(256 - t));
+  const __m256i c = _mm256_unpacklo_epi8(_mm256_set1_epi32(int(color)), zero);
+  const __m256i cterm = _mm256_add_epi16(
+      _mm256_mullo_epi16(c, _mm256_set1_epi16(short(t))),
+      _mm256_set1_epi16(128));
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+    lo = _mm256_srli_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(lo, wt), cterm), 8);
+    hi = _mm256_srli_epi16(
+        _mm256_add_epi16(_mm256_mullo_epi16(hi, wt), cterm), 8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i),
+                        _mm256_packus_epi16(lo, hi));
+  }
+  lerpSse2(dst + i, src + i, count - i, color, t);
+}
+
+MOUNTAINS_TARGET("avx2")
+void scaleAvx2(uint32_t *dst, const uint32_t *src, int count,
+               uint32_t factor) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i c255 = _mm256_set1_epi16(255);
+  const __m256i f = _mm256_set1_epi16(short(uint16_t(factor)));
+  const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000u));
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m256i lo = _mm256_slli_epi16(_mm256_unpacklo_epi8(v, zero), 8);
+    __m256i hi = _mm256_slli_epi16(_mm256_unpackhi_epi8(v, zero), 8);
+    lo = _mm256_min_epu16(_mm256_mulhi_epu16(lo, f), c255);
+    hi = _mm256_min_epu16(_mm256_mulhi_epu16(hi, f), c255);
+    __m256i out = _mm256_packus_epi16(lo, hi);
+    out = _mm256_blendv_epi8(out, v, alphaMask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+  }
+  scaleSse2(dst + i, src + i, count - i, factor);
+}
+
+MOUNTAINS_TARGET("avx2")
+__m256i overHalfAvx2(__m256i s, __m256i d) {
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+  a = _mm256_add_epi16(a, _mm256_srli_epi16(a, 7));
+  __m256i ia = _mm256_sub_epi16(_mm256_set1_epi16(256), a);
+  __m256i sum =
+      _mm256_add_epi16(_mm256_mullo_epi16(s, a), _mm256_mullo_epi16(d, ia));
+  return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(128)), 8);
+}
+
+MOUNTAINS_TARGET("avx2")
+void overAvx2(uint32_t *dst, const uint32_t *src, int count) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i alphaMask = _mm256_set1_epi32(int(0xFF000000u));
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+    __m256i lo = overHalfAvx2(_mm256_unpacklo_epi8(s, zero),
+                              _mm256_unpacklo_epi8(d, zero));
+    __m256i hi = overHalfAvx2(_mm256_unpackhi_epi8(s, zero),
+                              _mm256_unpackhi_epi8(d, zero));
+    __m256i out = _mm256_blendv_epi8(_mm256_packus_epi16(lo, hi), d, alphaMask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), out);
+  }
+  overSse2(dst + i, src + i, count - i);
+}
+#endif
+
+struct ColorKernels {
+  void (*lerp)(uint32_t *, const uint32_t *, int, uint32_t, uint32_t);
+  void (*scale)(uint32_t *, const uint32_t *, int, uint32_t);
+  void (*over)(uint32_t *, const uint32_t *, int);
+  const char *isa;
+};
+
+ColorKernels pickKernels() {
+#ifdef MOUNTAINS_X86
+  if (cpu_has_avx2())
+    return {lerpAvx2, scaleAvx2, overAvx2, "avx2"};
+  if (cpu_has_sse2())
+    return {lerpSse2, scaleSse2, overSse2, "sse2"};
+#endif
+  return {lerpScalar, scaleScalar, overScalar, "scalar"};
+}
+
+const ColorKernels &kernels() {
+  static const ColorKernels k = pickKernels();
+  return k;
+}
+
+} // namespace
+
+void lerp_span(uint32_t *dst, const uint32_t *src, int count, uint32_t color,
+               uint32_t t) {
+  kernels().lerp(dst, src, count, color, std::min<uint32_t>(t, 256));
+}
+
+void scale_span(uint32_t *dst, const uint32_t *src, int count,
+                uint32_t factor) {
+  kernels().scale(dst, src, count, std::min<uint32_t>(factor, 0xFFFF));
+}
+
+void over_span(uint32_t *dst, const uint32_t *src, int count) {
+  kernels().over(dst, src, count);
+}
+
+const char *color_kernels_isa() { return kernels().isa; }
+
+void gradient_rows(uint32_t *out, int count, uint32_t first, uint32_t last) {
+  if (count <= 0)
+    return;
+  const uint32_t den = uint32_t(std::max(1, count - 1));
+  for (int i = 0; i < count; ++i)
+    out[i] = blend_argb_q8(first, last, (uint32_t(i) * 256 + den / 2) / den);
+}
+
+void fill_gradient_rows(uint32_t *pixels, int rowStride, int x0, int x1,
+                        int y0, int y1, const uint32_t *rowColors) {
+  for (int y = y0; y < y1; ++y)
+    fill_span(pixels + size_t(y) * rowStride + x0, x1 - x0, rowColors[y]);
+}
+
+void fill_gradient_rows(uint16_t *pixels, int rowStride, int x0, int x1,
+                        int y0, int y1, const uint16_t *rowColors) {
+  for (int y = y0; y < y1; ++y)
+    fill_span(pixels + size_t(y) * rowStride + x0, x1 - x0, rowColors[y]);
+}
+
+void fill_vertical_gradient(uint32_t *pixels, int rowStride, int width,
+                            int height, uint32_t top, uint32_t bottom) {
+  const uint32_t den = uint32_t(std::max(1, height - 1));
+  for (int y = 0; y < height; ++y)
+    fill_span(pixels + size_t(y) * rowStride, width,
+              blend_argb_q8(top, bottom, (uint32_t(y) * 256 + den / 2) / den));
+}
+
+void fill_vertical_gradient(uint16_t *pixels, int rowStride, int width,
+                            int height, uint32_t top, uint32_t bottom) {
+  using T = PixelTraits<PixelFormat::RGB565>;
+  const uint32_t den = uint32_t(std::max(1, height - 1));
+  for (int y = 0; y < height; ++y)
+    fill_span(pixels + size_t(y) * rowStride, width,
+              T::pack(blend_argb_q8(top, bottom,
+                                    (uint32_t(y) * 256 + den / 2) / den)));
+}
@@ -0,0 +1,43 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#define MOUNTAINS_X86 1
+#endif
+
+bool cpu_has_sse2() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+  return true; // baseline on x86-64
+#elif defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+  return __builtin_cpu_supports("sse2");
+#elif defined(MOUNTAINS_X86)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[3] & (1 << 26)) != 0;
+#else
+  return false;
+#endif
+}
+
+bool cpu_has_avx2() noexcept {
+#if defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(MOUNTAINS_X86)
+  int info[4];
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,162 @@
+#include "FbmNoise.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define MOUNTAINS_X86 1
+#endif
+
+#if defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MOUNTAINS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MOUNTAINS_TARGET(isa)
+#endif
+
+namespace {
+
+constexpr uint32_t kLatticeMul = 0x9E3779B1u;
+constexpr double kGradientScale = 1.0 / 2147483648.0; // int32 -> [-1, 1)
+
+// Per-octave hash offset.
+uint32_t octaveSeed(uint32_t seed, int octave) {
+  return seed + uint32_t(octave) * 0x85EBCA77u;
+}
+
+// 32-bit integer hash (lowbias32); cheap in 32-bit SIMD lanes.
+inline uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352Du;
+  x ^= x >> 15;
+  x *= 0x846CA68Bu;
+  x ^= x >> 16;
+  return x;
+}
+
+inline double gradient(int32_t i, uint32_t seed) {
+  return double(int32_t(hash32(uint32_t(i) * kLatticeMul + seed))) *
+         kGradientScale;
+}
+
+// One octave at lattice coordinate t. The SIMD kernel below repeats these
+// operations one for one.
+inline double noise(double t, uint32_t seed) {
+  double fl = std::floor(t);
+  double f = t - fl;
+  int32_t i = int32_t(fl);
+  double a = gradient(i, seed) * f;
+  double b = gradient(i + 1, seed) * (f - 1.0);
+  double s = f * f * f * (f * (f * 6.0 - 15.0) + 10.0);
+  return 2.0 * (a + s * (b - a));
+}
+
+void fbmScalar(const FbmSpec &spec, const double *x, int count, double *out) {
+  for (int i = 0; i < count; ++i) {
+    double sum = 0.0, freq = spec.frequency;
+    for (int o = 0; o < spec.octaves; ++o, freq *= 2.0)
+      sum += spec.amplitude[o] * noise(x[i] * freq, octaveSeed(spec.seed, o));
+    out[i] = sum;
+  }
+}
+
+#ifdef MOUNTAINS_X86
+MOUNTAINS_TARGET("avx2")
+__m256i hash32x8(__m256i x) {
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32(int(0x7FEB352Du)));
+  x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+  x = _mm256_mullo_epi32(x, _mm256_set1_epi32(int(0x846CA68Bu)));
+  return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+MOUNTAINS_TARGET("avx2")
+__m256d gradients4(__m128i h) {
+  return _mm256_mul_pd(_mm256_cvtepi32_pd(h), _mm256_set1_pd(kGradientScale));
+}
+
+MOUNTAINS_TARGET("avx2")
+__m256d blend4(__m256d f, __m256d g0, __m256d g1) {
+  __m256d a = _mm256_mul_pd(g0, f);
+  __m256d b = _mm256_mul_pd(g1, _mm256_sub_pd(f, _mm256_set1_pd(1.0)));
+  __m256d s = _mm256_mul_pd(_mm256_mul_pd(f, f), f);
+  __m256d p = _mm256_sub_pd(_mm256_mul_pd(f, _mm256_set1_pd(6.0)),
+                            _mm256_set1_pd(15.0));
+  p = _mm256_add_pd(_mm256_mul_pd(f, p), _mm256_set1_pd(10.0));
+  s = _mm256_mul_pd(s, p);
+  __m256d r = _mm256_add_pd(a, _mm256_mul_pd(s, _mm256_sub_pd(b, a)));
+  return _mm256_mul_pd(_mm256_set1_pd(2.0), r);
+}
+
+// noise() for two groups of four coordinates; the eight lattice indices
+// hash together in one 32-bit vector.
+MOUNTAINS_TARGET("avx2")
+void noise8(__m256d t0, __m256d t1, uint32_t seed, __m256d &n0, __m256d &n1) {
+  __m256d fl0 = _mm256_floor_pd(t0), fl1 = _mm256_floor_pd(t1);
+  __m256i i = _mm256_set_m128i(_mm256_cvttpd_epi32(fl1),
+                               _mm256_cvttpd_epi32(fl0));
+  const __m256i mul = _mm256_set1_epi32(int(kLatticeMul));
+  const __m256i sd = _mm256_set1_epi32(int(seed));
+  __m256i h0 = hash32x8(_mm256_add_epi32(_mm256_mullo_epi32(i, mul), sd));
+  __m256i h1 = hash32x8(_mm256_add_epi32(
+      _mm256_mullo_epi32(_mm256_add_epi32(i, _mm256_set1_epi32(1)), mul),
+      sd));
+  n0 = blend4(_mm256_sub_pd(t0, fl0),
+              gradients4(_mm256_castsi256_si128(h0)),
+              gradients4(_mm256_castsi256_si128(h1)));
+  n1 = blend4(_mm256_sub_pd(t1, fl1),
+              gradients4(_mm256_extracti128_si256(h0, 1)),
+              gradients4(_mm256_extracti128_si256(h1, 1)));
+}
+
+MOUNTAINS_TARGET("avx2")
+void fbmAvx2(const FbmSpec &spec, const double *x, int count, double *out) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256d x0 = _mm256_loadu_pd(x + i), x1 = _mm256_loadu_pd(x + i + 4);
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    double freq = spec.frequency;
+    for (int o = 0; o < spec.octaves; ++o, freq *= 2.0) {
+      __m256d fq = _mm256_set1_pd(freq);
+      __m256d n0, n1;
+      noise8(_mm256_mul_pd(x0, fq), _mm256_mul_pd(x1, fq),
+             octaveSeed(spec.seed, o), n0, n1);
+      __m256d amp = _mm256_set1_pd(spec.amplitude[o]);
+      s0 = _mm256_add_pd(s0, _mm256_mul_pd(amp, n0));
+      s1 = _mm256_add_pd(s1, _mm256_mul_pd(amp, n1));
+    }
+    _mm256_storeu_pd(out + i, s0);
+    _mm256_storeu_pd(out + i + 4, s1);
+  }
+  fbmScalar(spec, x + i, count - i, out + i);
+}
+#endif
+
+struct FbmKernel {
+  void (*run)(const FbmSpec &, const double *, int, double *);
+  const char *isa;
+};
+
+FbmKernel pickKernel() {
+#ifdef MOUNTAINS_X86
+  if (cpu_has_avx2())
+    return {fbmAvx2, "avx2"};
+#endif
+  return {fbmScalar, "scalar"};
+}
+
+const FbmKernel &kernel() {
+  static const FbmKernel k = pickKernel();
+  return k;
+}
+
+} // namespace
+
+void fbm_noise(const FbmSpec &spec, const double *x, int count, double *out) {
+  FbmSpec s = spec;
+  s.octaves = std::clamp(s.octaves, 0, kFbmMaxOctaves);
+  kernel().run(s, x, count, out);
+}
+
+const char *fbm_noise_isa() { return kernel().isa; }
@@ -0,0 +1,76 @@
+#include "FramePacer.h"
+#include <algorithm>
+#include <thread>
+
+namespace {
+// Sleeps wake late by an OS-dependent amount; the spin margin follows the
+// observed lateness within these bounds.
+constexpr std::chrono::microseconds kMinSpinMargin{200};
+constexpr std::chrono::microseconds kMaxSpinMargin{4000};
+constexpr std::chrono::microseconds kSpinSlack{100};
+// An uncapped frame that presented nothing sleeps this long.
+constexpr std::chrono::microseconds kIdleSleep{1000};
+} // namespace
+
+FramePacer::FramePacer(double targetHz) : spinMargin_(kMinSpinMargin * 5) {
+  setTargetRate(targetHz);
+}
+
+void FramePacer::setTargetRate(double hz) {
+  targetHz_ = hz > 0.0 ? hz : 0.0;
+  period_ = targetHz_ > 0.0
+                ? std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(1.0 / targetHz_))
+                : Clock::duration::zero();
+  deadline_ = frameStart_ + period_;
+}
+
+double FramePacer::beginFrame() {
+  Clock::time_point now = Clock::now();
+  double dt = 0.0;
+  if (started_)
+    dt = std::chrono::duration<double>(now - frameStart_).count();
+  else
+    deadline_ = now + period_;
+  started_ = true;
+  frameStart_ = now;
+  return dt;
+}
+
+void FramePacer::endFrame(bool presented) {
+  Clock::time_point now = Clock::now();
+  lastCost_ = std::chrono::duration<double>(now - frameStart_).count();
+  if (uncapped()) {
+    if (!presented && idleSleep_)
+      std::this_thread::sleep_for(kIdleSleep);
+    return;
+  }
+  // More than a whole period behind (a hitch, or vsync slower than the
+  // target): start over from now instead of rushing frames to catch up.
+  if (now > deadline_ + period_)
+    deadline_ = now;
+  waitUntil(deadline_, presented);
+  deadline_ += period_;
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline, bool spin) {
+  if (!spin) {
+    std::this_thread::sleep_until(deadline);
+    return;
+  }
+  Clock::time_point now = Clock::now();
+  if (deadline - now > spinMargin_) {
+    Clock::time_point wakeAt = deadline - spinMargin_;
+    std::this_thread::sleep_until(wakeAt);
+    now = Clock::now();
+    Clock::duration late = now - wakeAt;
+    if (late + kSpinSlack > spinMargin_)
+      spinMargin_ = late + kSpinSlack;
+    else
+      spinMargin_ -= (spinMargin_ - late - kSpinSlack) / 16;
+    spinMargin_ = std::clamp<Clock::duration>(spinMargin_, kMinSpinMargin,
+                                              kMaxSpinMargin);
+  }
+  while (Clock::now() < deadline)
+    std::this_thread::yield();
+}
@@ -0,0 +1,126 @@
+#include "HeadlessRenderer.h"
+#include "ImageWriter.h"
+#include "Profiler.h"
+#include <cstring>
+
+void HeadlessRenderer::requestPixelFormat(PixelFormat format) {
+  requested_ = format;
+}
+
+bool HeadlessRenderer::init(int width, int height, const char * /*title*/) {
+  format_ = requested_;
+  if (!resize(width, height))
+    return false;
+  framesPresented_ = 0;
+  framesPolled_ = 0;
+  return true;
+}
+
+bool HeadlessRenderer::resize(int width, int height) {
+  if (width <= 0 || height <= 0)
+    return false;
+  width_ = width;
+  height_ = height;
+  const size_t words = (rowBytes() * size_t(height) + 3) / 4;
+  staging_.assign(words, 0u);
+  frame_.assign(words, 0u);
+  staged_ = false;
+  return true;
+}
+
+void HeadlessRenderer::updateTexture(const void *pixels, int pitch) {
+  if (!pixels || staging_.empty())
+    return;
+  MOUNTAINS_PROFILE_SCOPE(Upload);
+  // pitch is provided in bytes-per-row by our callers
+  const auto *src = static_cast<const uint8_t *>(pixels);
+  auto *dst = reinterpret_cast<uint8_t *>(staging_.data());
+  const size_t bytes = rowBytes();
+  for (int y = 0; y < height_; ++y)
+    std::memcpy(dst + size_t(y) * bytes, src + size_t(y) * size_t(pitch),
+                bytes);
+  staged_ = true;
+}
+
+FrameBuffer HeadlessRenderer::beginFrame() {
+  FrameBuffer fb;
+  if (staging_.empty())
+    return fb;
+  fb.pixels = staging_.data();
+  fb.pitch = int(rowBytes());
+  return fb;
+}
+
+void HeadlessRenderer::endFrame() { staged_ = true; }
+
+void HeadlessRenderer::present() {
+  if (frame_.empty())
+    return;
+  MOUNTAINS_PROFILE_SCOPE(Present);
+  // Without a new frame the previous one is shown again.
+  if (staged_)
+    frame_.swap(staging_);
+  staged_ = false;
+  ++framesPresented_;
+}
+
+bool HeadlessRenderer::pollEvents(std::vector<Event> &outEvents) {
+  outEvents.clear();
+  if (frameLimit_ != 0 && framesPolled_ >= frameLimit_)
+    return false;
+  ++framesPolled_;
+  if (script_.empty())
+    return true;
+  outEvents = std::move(script_.front());
+  script_.pop_front();
+  for (const auto &e : outEvents) {
+    if (e.type == Event::Type::Quit)
+      return false;
+    if (e.type == Event::Type::Resize && !resize(e.x, e.y))
+      return false;
+  }
+  return true;
+}
+
+void HeadlessRenderer::cleanup() {
+  staging_.clear();
+  staging_.shrink_to_fit();
+  script_.clear();
+}
+
+void HeadlessRenderer::scriptEvents(std::vector<Event> batch) {
+  script_.push_back(std::move(batch));
+}
+
+void HeadlessRenderer::scriptKey(int code) {
+  Event down;
+  down.type = Event::Type::KeyDown;
+  down.code = code;
+  Event up = down;
+  up.type = Event::Type::KeyUp;
+  scriptEvents({down, up});
+}
+
+void HeadlessRenderer::scriptResize(int width, int height) {
+  Event e;
+  e.type = Event::Type::Resize;
+  e.x = width;
+  e.y = height;
+  scriptEvents({e});
+}
+
+bool HeadlessRenderer::saveFrame(const std::string &path) const {
+  if (frame_.empty())
+    return false;
+  if (format_ == PixelFormat::ARGB8888)
+    return write_image(path, frame_.data(), width_, height_, width_);
+  std::vector<uint32_t> argb(size_t(width_) * size_t(height_));
+  with_pixel_format(format_, [&](auto traits) {
+    using T = decltype(traits);
+    const auto *src = reinterpret_cast<const typename T::Pixel *>(
+        frame_.data());
+    for (size_t i = 0; i < argb.size(); ++i)
+      argb[i] = T::unpack(src[i]);
+  });
+  return write_image(path, argb.data(), width_, height_, width_);
+}
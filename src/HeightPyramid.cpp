@@ -0,0 +1,152 @@
+#include "HeightPyramid.h"
+#include <algorithm>
+
+// Every level lives in one buffer: level 0's samples, then avg, min and max
+// of each further level. The layout depends only on the sample count.
+void HeightPyramid::layout(int count) {
+  levels_.clear();
+  if (count <= 0)
+    return;
+  size_t total = 0;
+  for (size_t n = size_t(count);; n = (n + 1) / 2) {
+    Level l;
+    l.count = n;
+    l.avg = total;
+    l.min = l.max = total; // level 0: all three are the samples
+    total += n;
+    if (!levels_.empty()) {
+      l.min = total;
+      l.max = total + n;
+      total += 2 * n;
+    }
+    levels_.push_back(l);
+    if (n == 1)
+      break;
+  }
+}
+
+size_t HeightPyramid::storageSize() const {
+  if (levels_.empty())
+    return 0;
+  const Level &top = levels_.back();
+  return std::max(top.avg, top.max) + top.count;
+}
+
+size_t HeightPyramid::storageSize(int count) {
+  HeightPyramid p;
+  p.layout(count);
+  return p.storageSize();
+}
+
+void HeightPyramid::attach(const double *storage, int count,
+                           std::shared_ptr<const void> owner) {
+  layout(count);
+  data_.clear();
+  data_.shrink_to_fit();
+  external_ = levels_.empty() ? nullptr : storage;
+  owner_ = std::move(owner);
+}
+
+void HeightPyramid::build(const double *samples, int count) {
+  external_ = nullptr;
+  owner_.reset();
+  layout(count);
+  if (levels_.empty()) {
+    data_.clear();
+    return;
+  }
+  // A rebuild reuses the buffer's capacity.
+  data_.resize(storageSize());
+  std::copy(samples, samples + count, data_.begin());
+
+  for (size_t k = 1; k < levels_.size(); ++k)
+    reduce(k, 0, levels_[k].count);
+}
+
+void HeightPyramid::update(const double *samples, int first, int last) {
+  if (external_ || levels_.empty())
+    return;
+  first = std::max(first, 0);
+  last = std::min(last, size() - 1);
+  if (first > last)
+    return;
+  std::copy(samples + first, samples + last + 1, data_.begin() + first);
+  // Entry i of a level covers entries 2i and 2i + 1 of the one below.
+  size_t a = size_t(first), b = size_t(last);
+  for (size_t k = 1; k < levels_.size(); ++k) {
+    a /= 2;
+    b /= 2;
+    reduce(k, a, b + 1);
+  }
+}
+
+void HeightPyramid::reduce(size_t k, size_t i0, size_t i1) {
+  const Level &src = levels_[k - 1], &dst = levels_[k];
+  const double *srcAvg = data_.data() + src.avg;
+  const double *srcMin = data_.data() + src.min;
+  const double *srcMax = data_.data() + src.max;
+  double *avg = data_.data() + dst.avg;
+  double *mn = data_.data() + dst.min;
+  double *mx = data_.data() + dst.max;
+  for (size_t i = i0; i < i1; ++i) {
+    // An odd last entry pairs with itself.
+    size_t a = 2 * i, b = std::min(2 * i + 1, src.count - 1);
+    avg[i] = 0.5 * (srcAvg[a] + srcAvg[b]);
+    mn[i] = std::min(srcMin[a], srcMin[b]);
+    mx[i] = std::max(srcMax[a], srcMax[b]);
+  }
+}
+
+void HeightPyramid::resample(int width, Filter filter, double *out) const {
+  const int n = size();
+  if (n == 0 || width <= 0)
+    return;
+
+  // Column x covers samples [x * n / width, (x + 1) * n / width). Positions
+  // advance by an exact integer DDA, so there is no divide per column.
+  int level = 0;
+  while (level + 1 < levels() && (int64_t(width) << (level + 1)) <= n)
+    ++level;
+  // In units of level entries, a column is n / denom wide.
+  const int64_t denom = int64_t(width) << level;
+  const int64_t step = n / denom, stepRem = n % denom;
+  const Level &lv = levels_[size_t(level)];
+  const double *base = storage();
+  const double *avg = base + lv.avg;
+  const double *lo = base + lv.min;
+  const double *hi = base + lv.max;
+  const int64_t last = int64_t(lv.count) - 1;
+
+  int64_t pos = 0, rem = 0;
+  for (int x = 0; x < width; ++x) {
+    int64_t a = std::min(pos, last);
+    pos += step;
+    rem += stepRem;
+    if (rem >= denom) {
+      rem -= denom;
+      ++pos;
+    }
+    if (level == 0 && width >= n) {
+      out[x] = avg[size_t(a)]; // magnifying: nearest sample
+      continue;
+    }
+    int64_t b = std::min(std::max(a + 1, pos + (rem > 0 ? 1 : 0)), last + 1);
+    double v;
+    switch (filter) {
+    case Filter::Min:
+      v = *std::min_element(lo + a, lo + b);
+      break;
+    case Filter::Max:
+      v = *std::max_element(hi + a, hi + b);
+      break;
+    default: {
+      double sum = 0.0;
+      for (int64_t i = a; i < b; ++i)
+        sum += avg[size_t(i)];
+      v = sum / double(b - a);
+      break;
+    }
+    }
+    out[x] = v;
+  }
+}
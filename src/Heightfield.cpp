@@ -0,0 +1,165 @@
+#include "Heightfield.h"
+#include "MidpointDisplacement.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// Steps with fewer samples than this are not worth a parallelFor().
+constexpr size_t kMinParallelSamples = 1 << 14;
+
+// Call fn(r0, r1) over [0, rows) in contiguous blocks, on 'pool' when the
+// step has enough samples to split.
+template <class Fn>
+void forRowBlocks(ThreadPool *pool, int rows, size_t perRow, Fn &&fn) {
+  if (!pool || rows < 2 || size_t(rows) * perRow < kMinParallelSamples) {
+    fn(0, rows);
+    return;
+  }
+  int blocks = std::min(rows, pool->concurrency() * 4);
+  pool->parallelFor(blocks, [&](int b) {
+    fn(int(int64_t(rows) * b / blocks), int(int64_t(rows) * (b + 1) / blocks));
+  });
+}
+
+} // namespace
+
+void Heightfield::generate(const MountainParams &params, ThreadPool *pool) {
+  params.validate();
+  int k = 1;
+  while (((1 << k) + 1) < std::max(3, params.width))
+    ++k;
+  const int n = (1 << k) + 1;
+  n_ = n;
+  tilesX_ = (n + kTile - 1) / kTile;
+  data_.assign(size_t(tilesX_) * size_t(tilesX_) * kTile * kTile, 0.0f);
+
+  float *h = data_.data();
+  h[index(0, 0)] = h[index(0, n - 1)] = float(params.leftHeight);
+  h[index(n - 1, 0)] = h[index(n - 1, n - 1)] = float(params.rightHeight);
+
+  const uint64_t key = midpoint_key(params.seed);
+  auto offset = [&](int step, int x, int y, double disp) {
+    return disp * midpoint_random(key, step, uint64_t(y) * uint64_t(n) + x);
+  };
+  double disp = params.initialDisplacement;
+  for (int level = 0, s = n - 1; s > 1; ++level, s /= 2) {
+    const int half = s / 2;
+    const int cells = 1 << level;
+    // Diamond: cell centers from the four cell corners.
+    forRowBlocks(pool, cells, size_t(cells), [&](int r0, int r1) {
+      for (int cy = r0; cy < r1; ++cy) {
+        const int y = cy * s + half;
+        const float *up = h + rowOffset(y - half);
+        const float *down = h + rowOffset(y + half);
+        float *mid = h + rowOffset(y);
+        for (int x = half; x < n; x += s) {
+          const size_t l = colOffset(x - half), r = colOffset(x + half);
+          double sum = double(up[l]) + double(up[r]) + double(down[l]) +
+                       double(down[r]);
+          mid[colOffset(x)] =
+              float(0.25 * sum + offset(2 * level, x, y, disp));
+        }
+      }
+    });
+    // Square: edge midpoints from the corners and centers beside them;
+    // along the border only three neighbours exist.
+    forRowBlocks(pool, 2 * cells + 1, size_t(cells), [&](int r0, int r1) {
+      for (int j = r0; j < r1; ++j) {
+        const int y = j * half;
+        const float *up = y >= half ? h + rowOffset(y - half) : nullptr;
+        const float *down = y + half < n ? h + rowOffset(y + half) : nullptr;
+        float *mid = h + rowOffset(y);
+        for (int x = (j & 1) ? 0 : half; x < n; x += s) {
+          const size_t c = colOffset(x);
+          double sum = 0.0;
+          int count = 0;
+          if (x >= half) {
+            sum += double(mid[colOffset(x - half)]);
+            ++count;
+          }
+          if (x + half < n) {
+            sum += double(mid[colOffset(x + half)]);
+            ++count;
+          }
+          if (up) {
+            sum += double(up[c]);
+            ++count;
+          }
+          if (down) {
+            sum += double(down[c]);
+            ++count;
+          }
+          mid[c] =
+              float(sum / double(count) + offset(2 * level + 1, x, y, disp));
+        }
+      }
+    });
+    disp *= params.roughness;
+  }
+
+  // Normalize to [0, 1] by tile rows; padding outside the grid is skipped.
+  auto forTileRows = [&](int t0, int t1, auto &&visitRow) {
+    for (int ty = t0; ty < t1; ++ty) {
+      const int rows = std::min(kTile, n - ty * kTile);
+      for (int tx = 0; tx < tilesX_; ++tx) {
+        const int cols = std::min(kTile, n - tx * kTile);
+        float *tile = h + ((size_t(ty) * size_t(tilesX_) + size_t(tx))
+                           << (2 * kTileBits));
+        for (int yy = 0; yy < rows; ++yy)
+          visitRow(ty, tile + (yy << kTileBits), cols);
+      }
+    }
+  };
+  std::vector<float> lo(static_cast<size_t>(tilesX_)), hi(lo.size());
+  const size_t perTileRow = size_t(n) * kTile;
+  forRowBlocks(pool, tilesX_, perTileRow, [&](int t0, int t1) {
+    float mn = std::numeric_limits<float>::max();
+    float mx = std::numeric_limits<float>::lowest();
+    forTileRows(t0, t1, [&](int, const float *v, int cols) {
+      for (int i = 0; i < cols; ++i) {
+        mn = std::min(mn, v[i]);
+        mx = std::max(mx, v[i]);
+      }
+    });
+    std::fill(lo.begin() + t0, lo.begin() + t1, mn);
+    std::fill(hi.begin() + t0, hi.begin() + t1, mx);
+  });
+  const double mn = *std::min_element(lo.begin(), lo.end());
+  double r = double(*std::max_element(hi.begin(), hi.end())) - mn;
+  if (r <= 0.0)
+    r = 1.0;
+  const double scale = 1.0 / r;
+  forRowBlocks(pool, tilesX_, perTileRow, [&](int t0, int t1) {
+    forTileRows(t0, t1, [&](int, float *v, int cols) {
+      for (int i = 0; i < cols; ++i)
+        v[i] = float((double(v[i]) - mn) * scale);
+    });
+  });
+}
+
+void Heightfield::rowMax(int y0, int y1, double *out) const {
+  y0 = std::max(0, y0);
+  y1 = std::min(n_, y1);
+  if (y0 >= y1) {
+    std::fill(out, out + n_, 0.0);
+    return;
+  }
+  std::vector<float> best(size_t(tilesX_) * kTile,
+                          std::numeric_limits<float>::lowest());
+  for (int ty = y0 >> kTileBits; ty <= (y1 - 1) >> kTileBits; ++ty) {
+    const int r0 = std::max(y0 - ty * kTile, 0);
+    const int r1 = std::min(y1 - ty * kTile, kTile);
+    const float *row =
+        data_.data() + (size_t(ty) * size_t(tilesX_) << (2 * kTileBits));
+    for (int tx = 0; tx < tilesX_; ++tx) {
+      const float *tile = row + (size_t(tx) << (2 * kTileBits));
+      float *b = best.data() + size_t(tx) * kTile;
+      for (int yy = r0; yy < r1; ++yy)
+        for (int xx = 0; xx < kTile; ++xx)
+          b[xx] = std::max(b[xx], tile[(yy << kTileBits) | xx]);
+    }
+  }
+  std::copy(best.begin(), best.begin() + n_, out);
+}
@@ -0,0 +1,37 @@
+#include "HeightfieldLayer.h"
+#include "ThreadPool.h"
+
+HeightfieldLayer::HeightfieldLayer(std::shared_ptr<const Heightfield> terrain,
+                                   std::vector<MountainParams> slices,
+                                   ThreadPool *pool)
+    : MountainLayer(cutSlices(*terrain, std::move(slices), pool)),
+      terrain_(std::move(terrain)) {}
+
+std::vector<Mountain>
+HeightfieldLayer::cutSlices(const Heightfield &terrain,
+                            std::vector<MountainParams> slices,
+                            ThreadPool *pool) {
+  const int n = terrain.size();
+  const int count = int(slices.size());
+  std::vector<Mountain> out;
+  out.reserve(slices.size());
+  for (auto &p : slices) {
+    p.width = n;
+    out.emplace_back(std::move(p), false);
+  }
+  // Slice 0 is the farthest band, at the high-y end of the terrain.
+  auto cut = [&](int i) {
+    int band = count - 1 - i;
+    int y0 = int(int64_t(n) * band / count);
+    int y1 = int(int64_t(n) * (band + 1) / count);
+    std::vector<double> horizon(static_cast<size_t>(n));
+    terrain.rowMax(y0, y1, horizon.data());
+    out[size_t(i)].setSamples(std::move(horizon));
+  };
+  if (pool)
+    pool->parallelFor(count, cut);
+  else
+    for (int i = 0; i < count; ++i)
+      cut(i);
+  return out;
+}
@@ -0,0 +1,250 @@
+#include "ImageWriter.h"
+#include <array>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+bool hasSuffix(const std::string &s, const char *suffix) {
+  std::string suf(suffix);
+  return s.size() >= suf.size() &&
+         s.compare(s.size() - suf.size(), suf.size(), suf) == 0;
+}
+
+bool writeAll(const std::string &path, const std::string &header,
+              const std::vector<uint8_t> &body) {
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  bool ok = std::fwrite(header.data(), 1, header.size(), f) == header.size() &&
+            std::fwrite(body.data(), 1, body.size(), f) == body.size();
+  return std::fclose(f) == 0 && ok;
+}
+
+uint32_t crc32(const uint8_t *data, size_t n, uint32_t crc = 0) {
+  static const std::array<uint32_t, 256> table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  crc = ~crc;
+  for (size_t i = 0; i < n; ++i)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+uint32_t adler32(const uint8_t *data, size_t n) {
+  uint32_t a = 1, b = 0;
+  while (n > 0) {
+    // 5552 is the longest run before b can overflow 32 bits.
+    size_t chunk = n < 5552 ? n : 5552;
+    n -= chunk;
+    for (size_t i = 0; i < chunk; ++i) {
+      a += *data++;
+      b += a;
+    }
+    a %= 65521;
+    b %= 65521;
+  }
+  return (b << 16) | a;
+}
+
+void putBe32(std::vector<uint8_t> &out, uint32_t v) {
+  out.push_back(uint8_t(v >> 24));
+  out.push_back(uint8_t(v >> 16));
+  out.push_back(uint8_t(v >> 8));
+  out.push_back(uint8_t(v));
+}
+
+// Deflate bit stream: values LSB first, Huffman codes MSB first.
+class BitWriter {
+public:
+  explicit BitWriter(std::vector<uint8_t> &out) : out_(out) {}
+  void bits(uint32_t v, int n) {
+    acc_ |= uint64_t(v) << count_;
+    count_ += n;
+    while (count_ >= 8) {
+      out_.push_back(uint8_t(acc_));
+      acc_ >>= 8;
+      count_ -= 8;
+    }
+  }
+  void code(uint32_t c, int n) {
+    uint32_t r = 0;
+    for (int i = 0; i < n; ++i)
+      r |= ((c >> i) & 1u) << (n - 1 - i);
+    bits(r, n);
+  }
+  void flush() {
+    if (count_ > 0)
+      out_.push_back(uint8_t(acc_));
+    acc_ = 0;
+    count_ = 0;
+  }
+
+private:
+  std::vector<uint8_t> &out_;
+  uint64_t acc_ = 0;
+  int count_ = 0;
+};
+
+// Fixed Huffman literal/length alphabet (RFC 1951, 3.2.6).
+void putSymbol(BitWriter &w, int sym) {
+  if (sym < 144)
+    w.code(0x30u + uint32_t(sym), 8);
+  else if (sym < 256)
+    w.code(0x190u + uint32_t(sym - 144), 9);
+  else if (sym < 280)
+    w.code(uint32_t(sym - 256), 7);
+  else
+    w.code(0xC0u + uint32_t(sym - 280), 8);
+}
+
+const uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,   10,  11, 13,
+                                  15, 17, 19, 23, 27, 31, 35,  43,  51, 59,
+                                  67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                  2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Match of 'len' (3..258) bytes at distance 1.
+void putRun(BitWriter &w, int len) {
+  int i = 28;
+  while (kLengthBase[i] > len)
+    --i;
+  putSymbol(w, 257 + i);
+  if (kLengthExtra[i])
+    w.bits(uint32_t(len - kLengthBase[i]), kLengthExtra[i]);
+  w.code(0, 5); // distance code 0 = distance 1
+}
+
+void deflateRuns(const std::vector<uint8_t> &in, std::vector<uint8_t> &out) {
+  BitWriter w(out);
+  w.bits(1, 1); // final block
+  w.bits(1, 2); // fixed Huffman
+  const size_t n = in.size();
+  size_t i = 0;
+  while (i < n) {
+    if (i > 0) {
+      size_t run = 0;
+      while (run < 258 && i + run < n && in[i + run] == in[i - 1])
+        ++run;
+      if (run >= 3) {
+        putRun(w, int(run));
+        i += run;
+        continue;
+      }
+    }
+    putSymbol(w, in[i++]);
+  }
+  putSymbol(w, 256);
+  w.flush();
+}
+
+void putChunk(std::vector<uint8_t> &png, const char type[4],
+              const std::vector<uint8_t> &data) {
+  putBe32(png, uint32_t(data.size()));
+  size_t start = png.size();
+  png.insert(png.end(), type, type + 4);
+  png.insert(png.end(), data.begin(), data.end());
+  putBe32(png, crc32(png.data() + start, png.size() - start));
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_png(const uint32_t *pixels, int width, int height,
+                                int rowStride) {
+  if (!pixels || width <= 0 || height <= 0)
+    return {};
+  // Filtered scanlines: a filter byte (1 = Sub), then each byte minus the
+  // same channel of the pixel to its left.
+  const size_t rowBytes = size_t(width) * 3 + 1;
+  std::vector<uint8_t> raw(rowBytes * size_t(height));
+  for (int y = 0; y < height; ++y) {
+    const uint32_t *row = pixels + size_t(y) * rowStride;
+    uint8_t *out = raw.data() + size_t(y) * rowBytes;
+    *out++ = 1;
+    uint32_t prev = 0;
+    for (int x = 0; x < width; ++x) {
+      uint32_t c = row[x];
+      *out++ = uint8_t((c >> 16) - (prev >> 16));
+      *out++ = uint8_t((c >> 8) - (prev >> 8));
+      *out++ = uint8_t(c - prev);
+      prev = c;
+    }
+  }
+
+  std::vector<uint8_t> idat = {0x78, 0x01}; // zlib: deflate, 32K window
+  idat.reserve(raw.size() / 16);
+  deflateRuns(raw, idat);
+  putBe32(idat, adler32(raw.data(), raw.size()));
+
+  std::vector<uint8_t> ihdr;
+  putBe32(ihdr, uint32_t(width));
+  putBe32(ihdr, uint32_t(height));
+  ihdr.insert(ihdr.end(), {8, 2, 0, 0, 0}); // 8-bit RGB, no interlace
+
+  std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+  putChunk(png, "IHDR", ihdr);
+  putChunk(png, "IDAT", idat);
+  putChunk(png, "IEND", {});
+  return png;
+}
+
+bool write_png(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride) {
+  std::vector<uint8_t> png = encode_png(pixels, width, height, rowStride);
+  return !png.empty() && writeAll(path, std::string(), png);
+}
+
+bool write_ppm(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride) {
+  if (!pixels || width <= 0 || height <= 0)
+    return false;
+  std::vector<uint8_t> body(size_t(width) * size_t(height) * 3);
+  uint8_t *out = body.data();
+  for (int y = 0; y < height; ++y) {
+    const uint32_t *row = pixels + size_t(y) * rowStride;
+    for (int x = 0; x < width; ++x) {
+      uint32_t c = row[x];
+      *out++ = uint8_t(c >> 16);
+      *out++ = uint8_t(c >> 8);
+      *out++ = uint8_t(c);
+    }
+  }
+  std::string header = "P6\n" + std::to_string(width) + " " +
+                       std::to_string(height) + "\n255\n";
+  return writeAll(path, header, body);
+}
+
+bool write_raw(const std::string &path, const uint32_t *pixels, int width,
+               int height, int rowStride) {
+  if (!pixels || width <= 0 || height <= 0)
+    return false;
+  std::vector<uint8_t> body(size_t(width) * size_t(height) * 4);
+  uint8_t *out = body.data();
+  for (int y = 0; y < height; ++y) {
+    const uint32_t *row = pixels + size_t(y) * rowStride;
+    for (int x = 0; x < width; ++x) {
+      uint32_t c = row[x];
+      *out++ = uint8_t(c);
+      *out++ = uint8_t(c >> 8);
+      *out++ = uint8_t(c >> 16);
+      *out++ = uint8_t(c >> 24);
+    }
+  }
+  return writeAll(path, std::string(), body);
+}
+
+bool write_image(const std::string &path, const uint32_t *pixels, int width,
+                 int height, int rowStride) {
+  if (hasSuffix(path, ".ppm"))
+    return write_ppm(path, pixels, width, height, rowStride);
+  if (hasSuffix(path, ".png"))
+    return write_png(path, pixels, width, height, rowStride);
+  return write_raw(path, pixels, width, height, rowStride);
+}
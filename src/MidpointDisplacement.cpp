@@ -0,0 +1,66 @@
+#include "MidpointDisplacement.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+
+// Ranges smaller than this are not worth a parallelFor().
+constexpr int kMinParallelSamples = 1 << 16;
+
+// Apply one level to segments [s0, s1) of size 'step'.
+inline void displaceLevel(double *h, int level, uint64_t s0, uint64_t s1,
+                          uint64_t step, uint64_t key, double disp) {
+  const uint64_t half = step / 2;
+  for (uint64_t s = s0; s < s1; ++s) {
+    uint64_t l = s * step;
+    h[l + half] =
+        0.5 * (h[l] + h[l + step]) + disp * midpoint_random(key, level, s);
+  }
+}
+
+} // namespace
+
+void midpoint_displace_segments(double *h, int n, uint64_t key, int firstLevel,
+                                uint64_t segBegin, uint64_t segEnd,
+                                double disp, double roughness) {
+  uint64_t step = uint64_t(n - 1) >> firstLevel;
+  for (int level = firstLevel; step > 1; ++level) {
+    displaceLevel(h, level, segBegin, segEnd, step, key, disp);
+    segBegin *= 2;
+    segEnd *= 2;
+    step /= 2;
+    disp *= roughness; // use roughness multiplier
+  }
+}
+
+void midpoint_displace_levels(double *h, int n, uint64_t key, double disp,
+                              double roughness, ThreadPool *pool) {
+  if (n < 3)
+    return;
+  if (!pool || pool->concurrency() < 2 || n < kMinParallelSamples) {
+    midpoint_displace_segments(h, n, key, 0, 0, 1, disp, roughness);
+    return;
+  }
+
+  // Run the top levels serially until there are a few segments per thread;
+  // below that every segment's subtree is independent, so each task walks
+  // its own contiguous block of segments level by level.
+  const uint64_t blocks = uint64_t(pool->concurrency()) * 4;
+  uint64_t segments = 1;
+  uint64_t step = uint64_t(n - 1);
+  int level = 0;
+  while (segments < blocks && step > 2) {
+    displaceLevel(h, level, 0, segments, step, key, disp);
+    segments *= 2;
+    step /= 2;
+    disp *= roughness;
+    ++level;
+  }
+
+  const int tasks = int(std::min(blocks, segments));
+  pool->parallelFor(tasks, [&](int t) {
+    uint64_t b = segments * uint64_t(t) / uint64_t(tasks);
+    uint64_t e = segments * uint64_t(t + 1) / uint64_t(tasks);
+    midpoint_displace_segments(h, n, key, level, b, e, disp, roughness);
+  });
+}
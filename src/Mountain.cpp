@@ -1,35 +1,171 @@
 #include "Mountain.h"
+#include "ColorKernels.h"
+#include "MidpointDisplacement.h"
+#include "Profiler.h"
+#include "RidgeGenerator.h"
+#include "RenderUtils.h"
+#include "SampleKernels.h"
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 
-Mountain::Mountain(MountainParams params) : params_(std::move(params)) {
+Mountain::Mountain(MountainParams params)
+    : Mountain(std::move(params), true) {}
+
+Mountain::Mountain(MountainParams params, bool generateNow)
+    : params_(std::move(params)) {
   params_.validate();
-  generate();
+  if (generateNow)
+    generate();
+}
+
+void Mountain::generate(ThreadPool *pool) {
+  MOUNTAINS_PROFILE_SCOPE(MountainGenerate);
+  morphTarget_.reset();
+  generator_ = make_ridge_generator(params_);
+  if (generator_->randomAccess()) {
+    // Nothing to store: columns are evaluated when the size is known.
+    samples_.clear();
+    pyramid_.build(nullptr, 0);
+  } else {
+    heightScale_ = generator_->generate(samples_, pool);
+    pyramid_.build(samples_.data(), int(samples_.size()));
+  }
+  silW_ = silH_ = 0;
+}
+
+void Mountain::adoptPyramid(const double *storage,
+                            std::shared_ptr<const void> owner) {
+  generator_.reset();
+  morphTarget_.reset();
+  samples_.clear();
+  pyramid_.attach(storage, std::max(3, params_.width), std::move(owner));
+  silW_ = silH_ = 0;
+}
+
+void Mountain::setSamples(std::vector<double> samples) {
+  generator_.reset();
+  morphTarget_.reset();
+  samples_ = std::move(samples);
+  pyramid_.build(samples_.data(), int(samples_.size()));
+  silW_ = silH_ = 0;
 }
 
-void Mountain::generate() {
-  int targetWidth = params_.width;
-  if (targetWidth < 3)
-    targetWidth = 3;
-  int k = 1;
-  while (((1 << k) + 1) < targetWidth)
-    ++k;
-  int n = (1 << k) + 1;
-  samples_.assign(n, 0.0);
-  samples_.front() = params_.leftHeight;
-  samples_.back() = params_.rightHeight;
-  std::mt19937 rng(params_.seed);
-  midpoint_displace(samples_, 0, n - 1, params_.initialDisplacement, rng,
-                    params_.roughness);
-  double mn = *std::min_element(samples_.begin(), samples_.end());
-  double mx = *std::max_element(samples_.begin(), samples_.end());
-  double r = mx - mn;
-  if (r <= 0.0)
-    r = 1.0;
-  for (double &v : samples_)
-    v = (v - mn) / r;
-  if (n != targetWidth)
-    samples_.resize(targetWidth);
+void Mountain::setParams(MountainParams params) {
+  params.validate();
+  const MountainParams &o = params_;
+  bool reshape = params.width != o.width || params.seed != o.seed ||
+                 params.leftHeight != o.leftHeight ||
+                 params.rightHeight != o.rightHeight ||
+                 params.initialDisplacement != o.initialDisplacement ||
+                 params.roughness != o.roughness ||
+                 params.algorithm != o.algorithm;
+  params_ = std::move(params);
+  silW_ = silH_ = 0;
+  if (reshape)
+    generate();
+}
+
+const int16_t *Mountain::silhouette(int winW, int winH) {
+  if (const int16_t *t = cachedSilhouette(winW, winH))
+    return t;
+  if (winW != silW_ || winH != silH_) {
+    silhouette_.resize(size_t(winW));
+    edges_.resize(size_t(winW) * 2 + 1);
+    interior_.resize(size_t(winW));
+    rowColors_.resize(size_t(winH));
+    if (!mountain_row_colors(params_, winH, rowColors_.data()))
+      rowColors_.clear();
+    if (morphTarget_) {
+      resampleOwn(winW, fromCols_);
+      morphTarget_->resampleOwn(winW, toCols_);
+    } else {
+      resampleHeights(winW, columns_);
+    }
+  }
+  if (morphTarget_) {
+    columns_.resize(size_t(winW));
+    lerp_samples(columns_.data(), fromCols_.data(), toCols_.data(), winW,
+                 morphWeight_);
+  }
+  topsFromHeights(columns_.data(), winW, winH, silhouette_.data());
+  edgesFromHeights(columns_.data(), winW, winH, edges_.data());
+  aa_interior_rows(edges_.data(), 0, winW, winH, interior_.data());
+  silW_ = winW;
+  silH_ = winH;
+  morphStale_ = false;
+  return silhouette_.data();
+}
+
+void Mountain::beginMorph(std::shared_ptr<Mountain> target) {
+  morphTarget_ = std::move(target);
+  morphWeight_ = 0.0;
+  // Both shapes' columns are resampled by the next silhouette().
+  silW_ = silH_ = 0;
+}
+
+void Mountain::setMorphWeight(double weight) {
+  if (!morphTarget_)
+    return;
+  morphWeight_ = std::clamp(weight, 0.0, 1.0);
+  morphStale_ = true;
+}
+
+std::shared_ptr<Mountain> Mountain::finishMorph() {
+  if (!morphTarget_)
+    return nullptr;
+  Mountain &t = *morphTarget_;
+  params_.seed = t.params_.seed;
+  generator_ = t.generator_;
+  heightScale_ = t.heightScale_;
+  if (morphTarget_.use_count() == 1) {
+    samples_.swap(t.samples_);
+    std::swap(pyramid_, t.pyramid_);
+  } else {
+    samples_ = t.samples_;
+    pyramid_ = t.pyramid_;
+  }
+  // The target's columns at the cached size are the new shape's columns.
+  if (silW_ != 0) {
+    columns_.swap(toCols_);
+    morphStale_ = true;
+  }
+  return std::move(morphTarget_);
+}
+
+void Mountain::reset(MountainParams params, bool generateNow) {
+  params.validate();
+  params_ = std::move(params);
+  morphTarget_.reset();
+  morphStale_ = false;
+  silW_ = silH_ = 0;
+  if (generateNow) {
+    generate();
+    return;
+  }
+  // Empty, as after construction; clear() keeps the capacity.
+  generator_.reset();
+  samples_.clear();
+  pyramid_.build(nullptr, 0);
+}
+
+bool Mountain::sculpt(int x, int y, int winW, int winH, int radius) {
+  if (!generator_ || samples_.empty() || winW <= 0 || winH <= 0)
+    return false;
+  // The sample under the column's center, as the pyramid spreads columns.
+  const int count = int(samples_.size());
+  const double footprint = double(count) / double(winW);
+  int at = int(std::lround((double(x) + 0.5) * footprint - 0.5));
+  at = std::clamp(at, 0, count - 1);
+  int first = 0, last = 0;
+  if (!generator_->sculpt(samples_.data(), count, heightScale_, at,
+                          heightAtRow(y, winH),
+                          std::max(1, int(double(radius) * footprint)),
+                          &first, &last))
+    return false;
+  pyramid_.update(samples_.data(), first, last);
+  silW_ = silH_ = 0;
+  return true;
 }
 
 void Mountain::regenerate(uint32_t newSeed) {
@@ -37,46 +173,335 @@ void Mountain::regenerate(uint32_t newSeed) {
   generate();
 }
 
+int Mountain::topRow(double s, int winH) const noexcept {
+  double eff = params_.minHeight + s * (params_.maxHeight - params_.minHeight);
+  double scaled = eff * params_.verticalSpan;
+  int topY =
+      static_cast<int>((1.0 - scaled) * double(winH)) - params_.verticalOffset;
+  if (topY < 0)
+    topY = 0;
+  if (topY >= winH)
+    topY = winH - 1;
+  return topY;
+}
+
+double Mountain::heightAtRow(int y, int winH) const noexcept {
+  // topRow() solved for the sample, at the row's center.
+  double scaled =
+      1.0 - (double(y + params_.verticalOffset) + 0.5) / double(winH);
+  double eff = scaled / params_.verticalSpan;
+  double range = params_.maxHeight - params_.minHeight;
+  if (range <= 0.0)
+    return 0.0;
+  return std::clamp((eff - params_.minHeight) / range, 0.0, 1.0);
+}
+
+int32_t Mountain::edgeRow(double s, int winH) const noexcept {
+  double eff = params_.minHeight + s * (params_.maxHeight - params_.minHeight);
+  double scaled = eff * params_.verticalSpan;
+  double y = (1.0 - scaled) * double(winH) - params_.verticalOffset;
+  return int32_t(clampd(y * 256.0, 0.0, double(winH) * 256.0));
+}
+
+void Mountain::resampleOwn(int winW, std::vector<double> &out) const {
+  out.resize(size_t(winW));
+  if (generator_ && generator_->randomAccess()) {
+    // Column centers, with the columns spread over the samples as the
+    // pyramid spreads them.
+    const double count = double(std::max(3, params_.width));
+    const double footprint = count / double(winW);
+    thread_local std::vector<double> x;
+    x.resize(size_t(winW));
+    for (int i = 0; i < winW; ++i)
+      x[size_t(i)] = (double(i) + 0.5) * footprint - 0.5;
+    generator_->heightsAt(x.data(), winW, std::max(1.0, footprint),
+                          out.data());
+    return;
+  }
+  pyramid_.resample(winW, HeightPyramid::Filter::Max, out.data());
+}
+
+void Mountain::resampleHeights(int winW, std::vector<double> &out) const {
+  resampleOwn(winW, out);
+  if (!morphTarget_)
+    return;
+  thread_local std::vector<double> target;
+  morphTarget_->resampleOwn(winW, target);
+  lerp_samples(out.data(), out.data(), target.data(), winW, morphWeight_);
+}
+
+void Mountain::topsFromHeights(const double *heights, int winW, int winH,
+                               int16_t *out) const {
+  for (int x = 0; x < winW; ++x)
+    out[x] = static_cast<int16_t>(topRow(heights[x], winH));
+}
+
+void Mountain::edgesFromHeights(const double *heights, int winW, int winH,
+                                int32_t *out) const {
+  for (int x = 0; x < winW; ++x)
+    out[2 * x + 1] = edgeRow(heights[x], winH);
+  out[0] = out[1];
+  for (int x = 1; x < winW; ++x)
+    out[2 * x] = (out[2 * x - 1] + out[2 * x + 1]) / 2;
+  out[2 * winW] = out[2 * winW - 1];
+}
+
+void Mountain::columnTops(int winW, int winH, int16_t *out) const {
+  thread_local std::vector<double> heights;
+  resampleHeights(winW, heights);
+  topsFromHeights(heights.data(), winW, winH, out);
+}
+
+void Mountain::columnEdges(int winW, int winH, int32_t *out) const {
+  thread_local std::vector<double> heights;
+  resampleHeights(winW, heights);
+  edgesFromHeights(heights.data(), winW, winH, out);
+}
+
+void Mountain::render(const RenderContext &ctx, const int16_t *tops) const {
+  if (!ctx.pixels)
+    return;
+  const int x0 = std::max(0, ctx.clipX0), x1 = std::min(ctx.winW, ctx.clipX1);
+  const int y0 = std::max(0, ctx.clipY0), y1 = std::min(ctx.winH, ctx.clipY1);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+  MOUNTAINS_PROFILE_SCOPE(MountainPaint);
+  const uint32_t *rows = cachedRowColors(ctx.winW, ctx.winH);
+  if (!rows && params_.fogStrength > 0.0) {
+    thread_local std::vector<uint32_t> rowScratch;
+    rowScratch.resize(size_t(ctx.winH));
+    if (mountain_row_colors(params_, ctx.winH, rowScratch.data()))
+      rows = rowScratch.data();
+  }
+  if (ctx.antiAlias && !ctx.coverage) {
+    const int32_t *edges = cachedEdges(ctx.winW, ctx.winH);
+    const int16_t *interior = edges ? interior_.data() : nullptr;
+    if (!edges) {
+      thread_local std::vector<int32_t> scratch;
+      scratch.resize(size_t(ctx.winW) * 2 + 1);
+      columnEdges(ctx.winW, ctx.winH, scratch.data());
+      edges = scratch.data();
+    }
+    render_silhouette_aa(ctx, edges, params_.colorARGB, rows, interior);
+    return;
+  }
+  if (!tops)
+    tops = cachedSilhouette(ctx.winW, ctx.winH);
+  if (!tops) {
+    thread_local std::vector<int16_t> scratch;
+    scratch.resize(size_t(ctx.winW));
+    columnTops(ctx.winW, ctx.winH, scratch.data());
+    tops = scratch.data();
+  }
+  render_silhouette(ctx, tops, params_.colorARGB, rows);
+}
+
+bool mountain_row_colors(const MountainParams &p, int winH, uint32_t *out) {
+  if (p.fogStrength <= 0.0 || winH <= 0)
+    return false;
+  // The fog starts where the ridge could start: its top at sample 1.0.
+  double peak = p.maxHeight * p.verticalSpan;
+  int first = std::clamp(
+      static_cast<int>((1.0 - peak) * double(winH)) - p.verticalOffset, 0,
+      winH - 1);
+  uint32_t fogged =
+      blend_argb_q8(p.colorARGB, p.fogColor,
+                    uint32_t(std::lround(p.fogStrength * 256.0)));
+  fogged = (fogged & 0x00FFFFFFu) | (p.colorARGB & 0xFF000000u);
+  std::fill(out, out + first, p.colorARGB);
+  gradient_rows(out + first, winH - first, p.colorARGB, fogged);
+  return true;
+}
+
+namespace {
+// render_silhouette() in pixel format T.
+template <class T>
+void silhouetteAs(const RenderContext &ctx, const int16_t *tops, int x0,
+                  int y0, int x1, int y1, uint32_t argb,
+                  const uint32_t *rowColorsARGB) {
+  using Pixel = typename T::Pixel;
+  Pixel *pixels = static_cast<Pixel *>(ctx.pixels);
+  const Pixel pxColor = T::pack(argb);
+  const Pixel *rowColors =
+      rowColorsARGB ? pack_rows<T>(rowColorsARGB, y0, y1) : nullptr;
+  const int16_t *coverage = ctx.coverage;
+  if (ctx.raster) {
+    ctx.raster->build(tops, coverage, ctx.winW, ctx.winH, x0, y0, x1, y1);
+    if (rowColors)
+      ctx.raster->fill(pixels, ctx.rowStride, rowColors);
+    else
+      ctx.raster->fill(pixels, ctx.rowStride, pxColor);
+  } else {
+    for (int x = x0; x < x1; ++x) {
+      int topY = std::max<int>(tops[x], y0);
+      int bottom = coverage ? std::min<int>(coverage[x], y1) : y1;
+      for (int y = topY; y < bottom; ++y)
+        pixels[size_t(y) * ctx.rowStride + x] =
+            rowColors ? rowColors[y] : pxColor;
+    }
+  }
+}
+} // namespace
+
+void render_silhouette(const RenderContext &ctx, const int16_t *tops,
+                       uint32_t pxColor, const uint32_t *rowColors) {
+  const int x0 = std::max(0, ctx.clipX0), x1 = std::min(ctx.winW, ctx.clipX1);
+  const int y0 = std::max(0, ctx.clipY0), y1 = std::min(ctx.winH, ctx.clipY1);
+  if (!ctx.pixels || x0 >= x1 || y0 >= y1)
+    return;
+  with_pixel_format(ctx.format, [&](auto traits) {
+    silhouetteAs<decltype(traits)>(ctx, tops, x0, y0, x1, y1, pxColor,
+                                   rowColors);
+  });
+  int16_t *coverage = ctx.coverage;
+  if (coverage)
+    for (int x = x0; x < x1; ++x)
+      if (tops[x] < coverage[x])
+        coverage[x] = std::max<int16_t>(tops[x], static_cast<int16_t>(y0));
+}
+
+namespace {
+// Area of the unit-wide strip of row r lying below a straight edge running
+// from row 'a' to row 'b' (rows grow downward), in 1/256ths. Everything is
+// 24.8 fixed point. With u the edge's depth into the row, the covered height
+// at one x is clamp(1 - u, 0, 1); its integral over u is u - u^2 / 2, kept
+// exact as H = 512u - u^2 in 1/65536ths, and the average over the edge's
+// extent is (H(b) - H(a)) / (b - a).
+int segmentCoverage(int32_t a, int32_t b, int32_t r) {
+  if (a > b)
+    std::swap(a, b);
+  const int32_t r8 = r * 256;
+  if (a == b)
+    return std::clamp(r8 + 256 - a, 0, 256);
+  auto H = [r8](int32_t y) -> int64_t {
+    int64_t u = y - r8;
+    if (u <= 0)
+      return 512 * u;
+    if (u >= 256)
+      return 65536;
+    return 512 * u - u * u;
+  };
+  return int((H(b) - H(a)) / (2 * int64_t(b - a)));
+}
+
+// Edge pixels blended per batch: 32-bit pixels are gathered from their
+// columns with their coverage as source alpha, blended by over_span() and
+// scattered back. The batch lives on the stack, so no frame allocates.
+constexpr int kEdgeBatch = 256;
+
+struct EdgeBatch {
+  uint32_t src[kEdgeBatch];
+  uint32_t dst[kEdgeBatch];
+  uint32_t *at[kEdgeBatch];
+  int count = 0;
+
+  // Coverage a in (0, 256) as an over_span() alpha, which reads alpha
+  // alpha + alpha / 128: exact except that 128 becomes 127.
+  void add(uint32_t &px, uint32_t color, int a) {
+    src[count] = (color & 0x00FFFFFFu) | (uint32_t(a - (a >> 7)) << 24);
+    dst[count] = px;
+    at[count] = &px;
+    if (++count == kEdgeBatch)
+      flush();
+  }
+  void flush() {
+    over_span(dst, src, count);
+    for (int i = 0; i < count; ++i)
+      *at[i] = dst[i];
+    count = 0;
+  }
+};
+
+// Edge pixels of render_silhouette_aa() in pixel format T: rows from the
+// highest point of each column's edge down to tops[x], the interior.
+template <class T>
+void blendEdgesAs(const RenderContext &ctx, const int32_t *edges,
+                  const int16_t *tops, int x0, int y0, int x1, int y1,
+                  uint32_t argb, const uint32_t *rowColorsARGB) {
+  using Pixel = typename T::Pixel;
+  Pixel *pixels = static_cast<Pixel *>(ctx.pixels);
+  const Pixel pxColor = T::pack(argb);
+  const Pixel *rowColors =
+      rowColorsARGB ? pack_rows<T>(rowColorsARGB, y0, y1) : nullptr;
+  [[maybe_unused]] EdgeBatch batch;
+  for (int x = x0; x < x1; ++x) {
+    const int32_t l = edges[2 * x], c = edges[2 * x + 1], r = edges[2 * x + 2];
+    const int first = std::max(std::min({l, c, r}) >> 8, y0);
+    const int end = std::min<int>(tops[x], y1);
+    for (int y = first; y < end; ++y) {
+      int a = (segmentCoverage(l, c, y) + segmentCoverage(c, r, y) + 1) >> 1;
+      if (a <= 0)
+        continue;
+      const Pixel c = rowColors ? rowColors[y] : pxColor;
+      Pixel &px = pixels[size_t(y) * ctx.rowStride + x];
+      if (a >= 256)
+        px = c;
+      else if constexpr (sizeof(Pixel) == 4)
+        batch.add(px, c, a);
+      else
+        px = T::blend_q8(px, c, uint32_t(a));
+    }
+  }
+  if constexpr (sizeof(Pixel) == 4)
+    if (batch.count > 0)
+      batch.flush();
+}
+} // namespace
+
+void aa_interior_rows(const int32_t *edges, int x0, int x1, int winH,
+                      int16_t *out) {
+  // Every row at or below the edge's lowest point is covered.
+  for (int x = x0; x < x1; ++x) {
+    int32_t lo = std::max({edges[2 * x], edges[2 * x + 1], edges[2 * x + 2]});
+    out[x] = int16_t(std::min((lo + 255) >> 8, winH));
+  }
+}
+
+void render_silhouette_aa(const RenderContext &ctx, const int32_t *edges,
+                          uint32_t pxColor, const uint32_t *rowColors,
+                          const int16_t *interior) {
+  const int x0 = std::max(0, ctx.clipX0), x1 = std::min(ctx.winW, ctx.clipX1);
+  const int y0 = std::max(0, ctx.clipY0), y1 = std::min(ctx.winH, ctx.clipY1);
+  if (!ctx.pixels || x0 >= x1 || y0 >= y1)
+    return;
+  const int16_t *tops = interior;
+  if (!tops) {
+    thread_local std::vector<int16_t> scratch;
+    scratch.resize(size_t(ctx.winW));
+    aa_interior_rows(edges, x0, x1, ctx.winH, scratch.data());
+    tops = scratch.data();
+  }
+  RenderContext fill = ctx;
+  fill.coverage = nullptr;
+  render_silhouette(fill, tops, pxColor, rowColors);
+
+  with_pixel_format(ctx.format, [&](auto traits) {
+    blendEdgesAs<decltype(traits)>(ctx, edges, tops, x0, y0, x1, y1,
+                                   pxColor, rowColors);
+  });
+}
+
 void Mountain::paint(uint32_t *pixels, int rowStride, int winW,
                      int winH) const {
-  if (!pixels)
+  render(RenderContext{pixels, rowStride, winW, winH});
+}
+
+void Mountain::paintOccluded(uint32_t *pixels, int rowStride, int winW,
+                             int winH, int16_t *coverage) const {
+  if (!coverage)
     return;
-  int sampW = static_cast<int>(samples_.size());
-  // simple constant color painting (one color per mountain)
-  uint32_t pxColor = params_.colorARGB;
-  for (int x = 0; x < winW; ++x) {
-    int si = (sampW == winW)
-                 ? x
-                 : static_cast<int>((double(x) / double(winW)) * sampW);
-    if (si < 0)
-      si = 0;
-    if (si >= sampW)
-      si = sampW - 1;
-    double s = samples_[si];
-    double eff =
-        params_.minHeight + s * (params_.maxHeight - params_.minHeight);
-    double scaled = eff * params_.verticalSpan;
-    int topY = static_cast<int>((1.0 - scaled) * double(winH)) -
-               params_.verticalOffset;
-    if (topY < 0)
-      topY = 0;
-    if (topY >= winH)
-      topY = winH - 1;
-    for (int y = topY; y < winH; ++y)
-      pixels[y * rowStride + x] = pxColor;
-  }
-}
-
-void Mountain::midpoint_displace(std::vector<double> &h, int left, int right,
-                                 double disp, std::mt19937 &rng,
-                                 double roughness) {
-  if (right - left <= 1)
+  render(RenderContext{pixels, rowStride, winW, winH, coverage});
+}
+
+void Mountain::paintSpans(uint32_t *pixels, int rowStride, int winW, int winH,
+                          SpanRasterizer &raster) const {
+  render(RenderContext{pixels, rowStride, winW, winH, nullptr, &raster});
+}
+
+void Mountain::paintOccludedSpans(uint32_t *pixels, int rowStride, int winW,
+                                  int winH, int16_t *coverage,
+                                  SpanRasterizer &raster) const {
+  if (!coverage)
     return;
-  int mid = (left + right) / 2;
-  std::uniform_real_distribution<double> dist(-disp, disp);
-  double midVal = 0.5 * (h[left] + h[right]) + dist(rng);
-  h[mid] = midVal;
-  double nextDisp = disp * roughness; // use roughness multiplier
-  midpoint_displace(h, left, mid, nextDisp, rng, roughness);
-  midpoint_displace(h, mid, right, nextDisp, rng, roughness);
+  render(RenderContext{pixels, rowStride, winW, winH, coverage, &raster});
 }
@@ -3,11 +3,26 @@
 MountainLayer::MountainLayer(std::vector<Mountain> mountains)
     : mountains_(std::move(mountains)) {}
 
-void MountainLayer::update(double /*dt*/) {
-  // placeholder for animation
+void MountainLayer::setMorphing(double seconds) {
+  set_morphing(morpher_, seconds, mountains_);
+}
+
+void MountainLayer::update(double dt) {
+  if (update_morphing(morpher_, mountains_, dt))
+    markDirty();
+}
+
+void MountainLayer::prepare(int winW, int winH) {
+  for (auto &m : mountains_)
+    m.silhouette(winW, winH);
 }
 
 void MountainLayer::render(const RenderContext &ctx) {
+  if (ctx.coverage) {
+    for (auto it = mountains_.rbegin(); it != mountains_.rend(); ++it)
+      it->render(ctx);
+    return;
+  }
   for (const auto &m : mountains_)
-    m.paint(ctx.pixels, ctx.rowStride, ctx.winW, ctx.winH);
+    m.render(ctx);
 }
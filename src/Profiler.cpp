@@ -0,0 +1,151 @@
+#include "Profiler.h"
+#include "SpanRaster.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const char *const kZoneNames[] = {
+    "scene_update", "scene_render", "layer_render", "mountain_paint",
+    "mountain_generate", "upload", "present", "frame"};
+
+const uint32_t kZoneColors[] = {0xFFE05050u, 0xFFF09040u, 0xFFF0E050u,
+                                0xFF60D060u, 0xFF50D0E0u, 0xFF5080F0u,
+                                0xFFD060D0u};
+
+constexpr double kOverlayScaleMs = 1000.0 / 30.0; // full graph height
+constexpr int kGraphH = 64;
+constexpr int kBarH = 4;
+
+double toMs(uint64_t ns) { return double(ns) * 1e-6; }
+
+// Nearest-rank percentile of sorted values.
+uint64_t percentile(const uint64_t *sorted, int n, double p) {
+  int rank = int(std::ceil(p * n));
+  return sorted[std::clamp(rank - 1, 0, n - 1)];
+}
+
+// Darken a rectangle to half brightness, keeping alpha.
+template <class T>
+void shade(typename T::Pixel *pixels, int rowStride, int x0, int y0, int x1,
+           int y1) {
+  for (int y = y0; y < y1; ++y) {
+    typename T::Pixel *row = pixels + size_t(y) * rowStride;
+    for (int x = x0; x < x1; ++x)
+      row[x] = T::half(row[x]);
+  }
+}
+} // namespace
+
+const char *profile_zone_name(ProfileZone z) {
+  return kZoneNames[std::min<size_t>(size_t(z), Profiler::kZones)];
+}
+
+void Profiler::endFrame(uint64_t frameNs) noexcept {
+  uint64_t h = head_.load(std::memory_order_relaxed);
+  Frame &f = ring_[size_t(h % kHistory)];
+  for (int z = 0; z < kZones; ++z) {
+    f.ns[z] = openNs_[size_t(z)].exchange(0, std::memory_order_relaxed);
+    f.calls[z] = openCalls_[size_t(z)].exchange(0, std::memory_order_relaxed);
+  }
+  f.ns[kZones] = frameNs;
+  head_.store(h + 1, std::memory_order_release);
+}
+
+ProfileStats Profiler::stats(ProfileZone z) const {
+  ProfileStats s;
+  const int zi = std::min(int(z), kZones);
+  const int n = int(std::min<uint64_t>(framesRecorded(), kHistory));
+  if (n == 0)
+    return s;
+  uint64_t values[kHistory];
+  uint64_t sum = 0, calls = 0;
+  for (int i = 0; i < n; ++i) {
+    values[i] = ring_[size_t(i)].ns[zi];
+    sum += values[i];
+    calls += zi < kZones ? ring_[size_t(i)].calls[zi] : 1;
+  }
+  std::sort(values, values + n);
+  s.frames = n;
+  s.meanMs = toMs(sum) / n;
+  s.p50Ms = toMs(percentile(values, n, 0.50));
+  s.p95Ms = toMs(percentile(values, n, 0.95));
+  s.p99Ms = toMs(percentile(values, n, 0.99));
+  s.callsPerFrame = double(calls) / n;
+  return s;
+}
+
+void Profiler::writeCsv(std::FILE *f, bool header) const {
+  if (header)
+    std::fprintf(f, "frames,zone,calls_per_frame,mean_ms,p50_ms,p95_ms,"
+                    "p99_ms\n");
+  const unsigned long long frames = framesRecorded();
+  for (int z = 0; z <= kZones; ++z) {
+    ProfileStats s = stats(ProfileZone(z));
+    std::fprintf(f, "%llu,%s,%.2f,%.4f,%.4f,%.4f,%.4f\n", frames,
+                 kZoneNames[z], s.callsPerFrame, s.meanMs, s.p50Ms, s.p95Ms,
+                 s.p99Ms);
+  }
+  std::fflush(f);
+}
+
+void Profiler::writeJson(std::FILE *f) const {
+  std::fprintf(f, "{\"frames\":%llu",
+               static_cast<unsigned long long>(framesRecorded()));
+  for (int z = 0; z <= kZones; ++z) {
+    ProfileStats s = stats(ProfileZone(z));
+    std::fprintf(f,
+                 ",\"%s\":{\"calls_per_frame\":%.2f,\"mean_ms\":%.4f,"
+                 "\"p50_ms\":%.4f,\"p95_ms\":%.4f,\"p99_ms\":%.4f}",
+                 kZoneNames[z], s.callsPerFrame, s.meanMs, s.p50Ms, s.p95Ms,
+                 s.p99Ms);
+  }
+  std::fprintf(f, "}\n");
+  std::fflush(f);
+}
+
+void Profiler::drawOverlay(void *pixels, int rowStride, int winW, int winH,
+                           PixelFormat format) const {
+  if (!pixels)
+    return;
+  with_pixel_format(format, [&](auto traits) {
+    drawOverlayAs<decltype(traits)>(
+        static_cast<typename decltype(traits)::Pixel *>(pixels), rowStride,
+        winW, winH);
+  });
+}
+
+template <class T>
+void Profiler::drawOverlayAs(typename T::Pixel *pixels, int rowStride,
+                             int winW, int winH) const {
+  const int panelW = std::min(winW, kHistory);
+  const int panelH = std::min(winH, kGraphH + 2 + kZones * (kBarH + 1));
+  if (panelW <= 0 || panelH <= 0)
+    return;
+  shade<T>(pixels, rowStride, 0, 0, panelW, panelH);
+  const double pxPerMs = kGraphH / kOverlayScaleMs;
+
+  // Frame time graph, oldest frame on the left.
+  const uint64_t head = framesRecorded();
+  const int n = int(std::min<uint64_t>(head, uint64_t(panelW)));
+  for (int i = 0; i < n; ++i) {
+    const Frame &f = ring_[size_t((head - uint64_t(n - i)) % kHistory)];
+    int h = std::min(kGraphH, int(toMs(f.ns[kZones]) * pxPerMs + 0.5));
+    int x = panelW - n + i;
+    for (int y = std::max(0, kGraphH - h); y < std::min(kGraphH, panelH); ++y)
+      pixels[size_t(y) * rowStride + x] = T::pack(0xFFE0E0E0u);
+  }
+  int budgetY = kGraphH - int(1000.0 / 60.0 * pxPerMs + 0.5);
+  if (budgetY >= 0 && budgetY < panelH)
+    fill_span(pixels + size_t(budgetY) * rowStride, panelW,
+              T::pack(0xFF808080u));
+
+  // p95 per zone; the full panel width is one 60 Hz frame.
+  const double barPxPerMs = kHistory / (1000.0 / 60.0);
+  for (int z = 0; z < kZones; ++z) {
+    int w = std::min(panelW, int(stats(ProfileZone(z)).p95Ms * barPxPerMs));
+    int y0 = kGraphH + 2 + z * (kBarH + 1);
+    for (int y = y0; y < std::min(panelH, y0 + kBarH); ++y)
+      fill_span(pixels + size_t(y) * rowStride, std::max(1, w),
+                T::pack(kZoneColors[z]));
+  }
+}
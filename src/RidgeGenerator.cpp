@@ -0,0 +1,236 @@
+#include "RidgeGenerator.h"
+#include "FbmNoise.h"
+#include "MidpointDisplacement.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Samples of the generated ridge: the smallest 2^k + 1 covering the width.
+int latticeSamples(const MountainParams &p, int *levels = nullptr) {
+  int k = 1;
+  while (((1 << k) + 1) < std::max(3, p.width))
+    ++k;
+  if (levels)
+    *levels = k;
+  return (1 << k) + 1;
+}
+
+void midpointRecursive(std::vector<double> &h, int left, int right,
+                       double disp, std::mt19937 &rng, double roughness) {
+  if (right - left <= 1)
+    return;
+  int mid = (left + right) / 2;
+  std::uniform_real_distribution<double> dist(-disp, disp);
+  double midVal = 0.5 * (h[left] + h[right]) + dist(rng);
+  h[mid] = midVal;
+  double nextDisp = disp * roughness; // use roughness multiplier
+  midpointRecursive(h, left, mid, nextDisp, rng, roughness);
+  midpointRecursive(h, mid, right, nextDisp, rng, roughness);
+}
+
+// Midpoint displacement over 2^k + 1 samples, normalized by the ridge's own
+// min and max, then cut to the width.
+class MidpointGenerator : public RidgeGenerator {
+public:
+  explicit MidpointGenerator(const MountainParams &p) : p_(p) {}
+
+  double generate(std::vector<double> &samples,
+                  ThreadPool *pool) const override {
+    const int n = latticeSamples(p_);
+    samples.assign(size_t(n), 0.0);
+    samples.front() = p_.leftHeight;
+    samples.back() = p_.rightHeight;
+    if (p_.algorithm == RidgeAlgorithm::MidpointRecursive) {
+      std::mt19937 rng(p_.seed);
+      midpointRecursive(samples, 0, n - 1, p_.initialDisplacement, rng,
+                        p_.roughness);
+    } else {
+      midpoint_displace_levels(samples.data(), n, midpoint_key(p_.seed),
+                               p_.initialDisplacement, p_.roughness, pool);
+    }
+    double mn = *std::min_element(samples.begin(), samples.end());
+    double mx = *std::max_element(samples.begin(), samples.end());
+    double r = mx - mn;
+    if (r <= 0.0)
+      r = 1.0;
+    for (double &v : samples)
+      v = (v - mn) / r;
+    samples.resize(size_t(std::max(3, p_.width)));
+    return 1.0 / r;
+  }
+
+  // Sub-interval [l, l + step] of the lattice is segment l / step of the
+  // level with that step. Its midpoints depend only on its two ends and on
+  // their own (level, index) streams, so every sample is the linear blend
+  // of the ends plus a fixed detail term. Moving both ends of the interval
+  // holding 'at' by the same delta therefore lifts that interval by delta,
+  // and the intervals on either side by a ramp down to zero, while the
+  // detail stays as it was. Delta is measured against what the streams
+  // give 'at' from the current ends, found by walking the O(log step)
+  // midpoints above it, so finer edits inside are replaced, not stacked.
+  bool sculpt(double *samples, int count, double scale, int at, double height,
+              int radius, int *first, int *last) const override {
+    if (p_.algorithm != RidgeAlgorithm::MidpointHashed || count < 3)
+      return false;
+    const int n = latticeSamples(p_);
+    at = std::clamp(at, 0, count - 1);
+    // The lattice is cut to the width: near the right end, intervals shrink
+    // until they fit in the stored samples.
+    int step = 1;
+    while (step * 2 <= radius && step * 2 < n - 1)
+      step *= 2;
+    const int base = std::min(at, count - 2);
+    int q0 = base / step * step;
+    while (q0 + step > count - 1) {
+      step /= 2;
+      q0 = base / step * step;
+    }
+    const int q1 = q0 + step;
+    const int left = q0 > 0 ? step : 0;
+    int right = step;
+    while (right > 0 && q1 + right > count - 1)
+      right /= 2;
+
+    // Level 0 spans the lattice; displacement shrinks by roughness per
+    // level, multiplied in the same order as generate() does.
+    auto levelOf = [&](int segStep, double &disp) {
+      int level = 0;
+      disp = p_.initialDisplacement;
+      for (int s = n - 1; s > segStep; s /= 2, ++level)
+        disp *= p_.roughness;
+      disp *= scale;
+      return level;
+    };
+    const uint64_t key = midpoint_key(p_.seed);
+    auto regenerate = [&](int l, int segStep) {
+      if (segStep < 2)
+        return;
+      double disp = 0.0;
+      const int level = levelOf(segStep, disp);
+      const uint64_t seg = uint64_t(l / segStep);
+      midpoint_displace_segments(samples, n, key, level, seg, seg + 1, disp,
+                                 p_.roughness);
+    };
+
+    // Walk down to 'at': [l, l + s] holds it, with ends lo and hi.
+    double disp = 0.0;
+    int level = levelOf(step, disp);
+    double lo = samples[q0], hi = samples[q1];
+    int l = q0;
+    for (int s = step; at != l && at != l + s; s /= 2) {
+      const int half = s / 2;
+      const double mid = 0.5 * (lo + hi) +
+                         disp * midpoint_random(key, level, uint64_t(l / s));
+      if (at < l + half) {
+        hi = mid;
+      } else {
+        lo = mid;
+        l += half;
+      }
+      ++level;
+      disp *= p_.roughness;
+    }
+    const double value = at == l ? lo : hi;
+    const double delta = height - value;
+    samples[q0] += delta;
+    samples[q1] += delta;
+    if (left > 0)
+      regenerate(q0 - left, left);
+    regenerate(q0, step);
+    if (right > 0)
+      regenerate(q1, right);
+    *first = q0 - left;
+    *last = q1 + right;
+    return true;
+  }
+
+private:
+  MountainParams p_;
+};
+
+// fBm over the same lattice as the midpoint engines: octave o has cells of
+// 2^(k - o) samples and amplitude initialDisplacement * roughness^o, on a
+// baseline running from leftHeight to rightHeight. Every octave is zero at
+// both ends, so the ends keep their heights exactly. Without the whole
+// ridge to take a min and max from, heights map to [0, 1] through fixed
+// bounds like ChunkedRidge's: 2.5 standard deviations beyond the baseline,
+// with the rare samples past them clamped.
+class NoiseGenerator : public RidgeGenerator {
+public:
+  explicit NoiseGenerator(const MountainParams &p)
+      : count_(std::max(3, p.width)), left_(p.leftHeight),
+        right_(p.rightHeight) {
+    int k = 0;
+    span_ = double(latticeSamples(p, &k) - 1);
+    spec_.seed = uint32_t(midpoint_key(p.seed));
+    spec_.octaves = std::min(k, kFbmMaxOctaves);
+    spec_.frequency = 1.0 / span_;
+    double amp = p.initialDisplacement, var = 0.0;
+    for (int o = 0; o < spec_.octaves; ++o, amp *= p.roughness) {
+      spec_.amplitude[o] = amp;
+      var += amp * amp * kFbmOctaveVariance;
+    }
+    double bound = 2.5 * std::sqrt(var);
+    lo_ = std::min(left_, right_) - bound;
+    double range = std::max(left_, right_) + bound - lo_;
+    scale_ = range > 0.0 ? 1.0 / range : 1.0;
+  }
+
+  double generate(std::vector<double> &samples,
+                  ThreadPool * /*pool*/) const override {
+    samples.resize(size_t(count_));
+    thread_local std::vector<double> x;
+    x.resize(size_t(count_));
+    for (int i = 0; i < count_; ++i)
+      x[size_t(i)] = double(i);
+    heightsAt(x.data(), count_, 1.0, samples.data());
+    return scale_;
+  }
+
+  bool randomAccess() const override { return true; }
+
+  void heightsAt(const double *x, int count, double footprint,
+                 double *out) const override {
+    // Octaves whose cells are under two footprints wide fade out linearly
+    // and are gone at one.
+    FbmSpec spec = spec_;
+    double cell = span_;
+    for (int o = 0; o < spec.octaves; ++o, cell *= 0.5) {
+      double w = std::clamp(cell / footprint - 1.0, 0.0, 1.0);
+      spec.amplitude[o] *= w;
+      if (w == 0.0) {
+        spec.octaves = o;
+        break;
+      }
+    }
+    fbm_noise(spec, x, count, out);
+    for (int i = 0; i < count; ++i) {
+      double u = std::clamp(x[i] / span_, 0.0, 1.0);
+      double base = left_ + (right_ - left_) * u;
+      out[i] = std::clamp((base + out[i] - lo_) * scale_, 0.0, 1.0);
+    }
+  }
+
+private:
+  FbmSpec spec_;
+  int count_;
+  double span_;
+  double left_, right_;
+  double lo_, scale_;
+};
+
+} // namespace
+
+std::shared_ptr<const RidgeGenerator>
+make_ridge_generator(const MountainParams &params) {
+  switch (params.algorithm) {
+  case RidgeAlgorithm::FbmNoise:
+    return std::make_shared<NoiseGenerator>(params);
+  case RidgeAlgorithm::MidpointHashed:
+  case RidgeAlgorithm::MidpointRecursive:
+    break;
+  }
+  return std::make_shared<MidpointGenerator>(params);
+}
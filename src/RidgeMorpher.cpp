@@ -0,0 +1,139 @@
+#include "RidgeMorpher.h"
+#include "MidpointDisplacement.h"
+#include <algorithm>
+
+namespace {
+// Everything that shapes a ridge apart from its seed.
+bool sameShape(const MountainParams &a, const MountainParams &b) {
+  return a.width == b.width && a.leftHeight == b.leftHeight &&
+         a.rightHeight == b.rightHeight &&
+         a.initialDisplacement == b.initialDisplacement &&
+         a.roughness == b.roughness && a.algorithm == b.algorithm;
+}
+} // namespace
+
+RidgeMorpher::RidgeMorpher(double seconds, uint64_t seed)
+    : seconds_(seconds), seed_(seed) {
+  job_.owner = this;
+}
+
+RidgeMorpher::~RidgeMorpher() {
+  cancelled_.store(true, std::memory_order_relaxed);
+  BackgroundWorker::instance().cancel(job_);
+}
+
+void RidgeMorpher::request(const std::vector<Mountain> &mountains) {
+  const size_t count = mountains.size();
+  pending_.resize(count);
+  const uint64_t setSeed = seed_ + ++generation_ * 0x9E3779B97F4A7C15ull;
+  for (size_t i = 0; i < count; ++i) {
+    pending_[i] = mountains[i].params();
+    pending_[i].seed = uint32_t(ridge_seed(setSeed, i) >> 32);
+  }
+  // Slots the last morph handed over are refilled with the targets the
+  // morph before it returned; the worker makes any still missing.
+  ready_.resize(count);
+  for (size_t i = 0; i < count && i < spare_.size(); ++i)
+    if (!ready_[i])
+      ready_[i] = std::move(spare_[i]);
+  requested_ = true;
+  cancelled_.store(false, std::memory_order_relaxed);
+  building_.store(true, std::memory_order_release);
+  BackgroundWorker::instance().post(job_);
+}
+
+bool RidgeMorpher::requestedFor(const std::vector<Mountain> &mountains) const {
+  if (!requested_ || pending_.size() != mountains.size())
+    return false;
+  for (size_t i = 0; i < pending_.size(); ++i)
+    if (!sameShape(pending_[i], mountains[i].params()))
+      return false;
+  return true;
+}
+
+void RidgeMorpher::build() {
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    if (cancelled_.load(std::memory_order_relaxed))
+      break;
+    if (ready_[i])
+      ready_[i]->reset(pending_[i], false);
+    else
+      ready_[i] = std::make_shared<Mountain>(pending_[i], false);
+    ready_[i]->generate();
+  }
+  building_.store(false, std::memory_order_release);
+}
+
+bool RidgeMorpher::update(std::vector<Mountain> &mountains, double dt) {
+  if (mountains.empty() || seconds_ <= 0.0)
+    return false;
+  // Replaced mountains are not morphing: start over.
+  if (morphing_ && !std::all_of(mountains.begin(), mountains.end(),
+                                [](const Mountain &m) { return m.morphing(); }))
+    morphing_ = false;
+  // A set for other mountains is stopped and, once the worker lets go of
+  // it, requested again.
+  const bool building = building_.load(std::memory_order_acquire);
+  if (requested_ && !requestedFor(mountains))
+    cancelled_.store(true, std::memory_order_relaxed);
+  if (requested_ && !building && cancelled_.load(std::memory_order_relaxed))
+    requested_ = false;
+
+  if (!morphing_) {
+    if (!looping_)
+      return false;
+    if (!requested_) {
+      if (!building)
+        request(mountains);
+      return false;
+    }
+    if (building)
+      return false;
+    for (size_t i = 0; i < mountains.size(); ++i)
+      mountains[i].beginMorph(std::move(ready_[i]));
+    requested_ = false;
+    morphing_ = true;
+    progress_ = 0.0;
+    // The next set generates while this morph runs.
+    if (looping_)
+      request(mountains);
+  }
+
+  progress_ = std::min(1.0, progress_ + dt / seconds_);
+  if (progress_ >= 1.0) {
+    spare_.resize(mountains.size());
+    for (size_t i = 0; i < mountains.size(); ++i)
+      spare_[i] = mountains[i].finishMorph();
+    morphing_ = false;
+    return true;
+  }
+  const double w = progress_ * progress_ * (3.0 - 2.0 * progress_);
+  for (auto &m : mountains)
+    m.setMorphWeight(w);
+  return true;
+}
+
+void set_morphing(std::unique_ptr<RidgeMorpher> &morpher, double seconds,
+                  const std::vector<Mountain> &mountains) {
+  if (seconds <= 0.0) {
+    if (morpher)
+      morpher->setLooping(false);
+    return;
+  }
+  if (!morpher) {
+    uint32_t seed = mountains.empty() ? 0u : mountains[0].params().seed;
+    morpher = std::make_unique<RidgeMorpher>(seconds, mix64(seed));
+  }
+  morpher->setDuration(seconds);
+  morpher->setLooping(true);
+}
+
+bool update_morphing(std::unique_ptr<RidgeMorpher> &morpher,
+                     std::vector<Mountain> &mountains, double dt) {
+  if (!morpher)
+    return false;
+  bool changed = morpher->update(mountains, dt);
+  if (!morpher->looping() && morpher->idle())
+    morpher.reset();
+  return changed;
+}
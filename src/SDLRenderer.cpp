@@ -1,8 +1,28 @@
 #include "SDLRenderer.h"
+#include "Profiler.h"
 #include <iostream>
 
 SDLRenderer::~SDLRenderer() { cleanup(); }
 
+namespace {
+Uint32 sdlFormat(PixelFormat f) {
+  switch (f) {
+  case PixelFormat::XRGB8888:
+    return SDL_PIXELFORMAT_RGB888; // 32-bit XRGB, despite the name
+  case PixelFormat::RGB565:
+    return SDL_PIXELFORMAT_RGB565;
+  case PixelFormat::ARGB8888:
+    break;
+  }
+  return SDL_PIXELFORMAT_ARGB8888;
+}
+} // namespace
+
+void SDLRenderer::requestPixelFormat(PixelFormat format) {
+  requested_ = format;
+  formatRequested_ = true;
+}
+
 bool SDLRenderer::init(int width, int height, const char *title) {
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
     std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
@@ -10,7 +30,8 @@ bool SDLRenderer::init(int width, int height, const char *title) {
   }
 
   win_ = SDL_CreateWindow(title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                          width, height, SDL_WINDOW_SHOWN);
+                          width, height,
+                          SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
   if (!win_) {
     std::cerr << "SDL_CreateWindow failed: " << SDL_GetError() << "\n";
     SDL_Quit();
@@ -32,11 +53,11 @@ bool SDLRenderer::init(int width, int height, const char *title) {
     return false;
   }
 
-  // Create streaming texture in ARGB8888 format
-  tex_ = SDL_CreateTexture(ren_, SDL_PIXELFORMAT_ARGB8888,
-                           SDL_TEXTUREACCESS_STREAMING, width, height);
-  if (!tex_) {
-    std::cerr << "SDL_CreateTexture failed: " << SDL_GetError() << "\n";
+  format_ = requested_;
+  if (!formatRequested_ &&
+      SDL_BITSPERPIXEL(SDL_GetWindowPixelFormat(win_)) <= 16)
+    format_ = PixelFormat::RGB565;
+  if (!createTexture(width, height)) {
     SDL_DestroyRenderer(ren_);
     ren_ = nullptr;
     SDL_DestroyWindow(win_);
@@ -45,23 +66,66 @@ bool SDLRenderer::init(int width, int height, const char *title) {
     return false;
   }
 
+  return true;
+}
+
+// (Re)create the streaming texture in format_ at the given size.
+bool SDLRenderer::createTexture(int width, int height) {
+  endFrame();
+  if (tex_) {
+    SDL_DestroyTexture(tex_);
+    tex_ = nullptr;
+  }
+  tex_ = SDL_CreateTexture(ren_, sdlFormat(format_),
+                           SDL_TEXTUREACCESS_STREAMING, width, height);
+  if (!tex_) {
+    std::cerr << "SDL_CreateTexture failed: " << SDL_GetError() << "\n";
+    return false;
+  }
   width_ = width;
   height_ = height;
   return true;
 }
 
-void SDLRenderer::updateTexture(const uint32_t *pixels, int pitch) {
+void SDLRenderer::updateTexture(const void *pixels, int pitch) {
   if (!tex_)
     return;
+  MOUNTAINS_PROFILE_SCOPE(Upload);
   // pitch is provided in bytes-per-row by our callers
   if (SDL_UpdateTexture(tex_, nullptr, pixels, pitch) != 0) {
     std::cerr << "SDL_UpdateTexture failed: " << SDL_GetError() << "\n";
   }
 }
 
+FrameBuffer SDLRenderer::beginFrame() {
+  FrameBuffer fb;
+  if (!tex_ || locked_)
+    return fb;
+  MOUNTAINS_PROFILE_SCOPE(Upload);
+  void *pixels = nullptr;
+  int pitch = 0;
+  if (SDL_LockTexture(tex_, nullptr, &pixels, &pitch) != 0) {
+    std::cerr << "SDL_LockTexture failed: " << SDL_GetError() << "\n";
+    return fb;
+  }
+  locked_ = true;
+  fb.pixels = pixels;
+  fb.pitch = pitch;
+  return fb;
+}
+
+void SDLRenderer::endFrame() {
+  if (!locked_)
+    return;
+  MOUNTAINS_PROFILE_SCOPE(Upload);
+  SDL_UnlockTexture(tex_);
+  locked_ = false;
+}
+
 void SDLRenderer::present() {
   if (!ren_ || !tex_)
     return;
+  MOUNTAINS_PROFILE_SCOPE(Present);
   SDL_RenderClear(ren_);
   SDL_RenderCopy(ren_, tex_, nullptr, nullptr);
   SDL_RenderPresent(ren_);
@@ -101,8 +165,40 @@ bool SDLRenderer::pollEvents(std::vector<Event> &outEvents) {
       outEvents.push_back(e);
       break;
     }
-    // Add more SDL -> Event translations here if needed (mouse buttons, wheel,
-    // etc.)
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP: {
+      Event e;
+      e.type = ev.type == SDL_MOUSEBUTTONDOWN ? Event::Type::MouseDown
+                                              : Event::Type::MouseUp;
+      e.code = ev.button.button; // SDL_BUTTON_LEFT == MouseButton::Left
+      e.x = ev.button.x;
+      e.y = ev.button.y;
+      outEvents.push_back(e);
+      break;
+    }
+    case SDL_WINDOWEVENT: {
+      if (ev.window.event == SDL_WINDOWEVENT_EXPOSED) {
+        Event e;
+        e.type = Event::Type::Expose;
+        outEvents.push_back(e);
+        break;
+      }
+      if (ev.window.event != SDL_WINDOWEVENT_SIZE_CHANGED)
+        break;
+      int w = ev.window.data1, h = ev.window.data2;
+      if (w <= 0 || h <= 0 || (w == width_ && h == height_))
+        break;
+      // The old texture's contents are lost; the app redraws on Resize.
+      if (!createTexture(w, h))
+        return false;
+      Event e;
+      e.type = Event::Type::Resize;
+      e.x = w;
+      e.y = h;
+      outEvents.push_back(e);
+      break;
+    }
+    // Add more SDL -> Event translations here if needed (wheel, etc.)
     default:
       break;
     }
@@ -113,6 +209,7 @@ bool SDLRenderer::pollEvents(std::vector<Event> &outEvents) {
 }
 
 void SDLRenderer::cleanup() {
+  endFrame();
   if (tex_) {
     SDL_DestroyTexture(tex_);
     tex_ = nullptr;
@@ -0,0 +1,82 @@
+#include "SampleKernels.h"
+#include "CpuFeatures.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define MOUNTAINS_X86 1
+#endif
+
+#if defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MOUNTAINS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MOUNTAINS_TARGET(isa)
+#endif
+
+namespace {
+
+void lerpScalar(double *dst, const double *a, const double *b, int count,
+                double t) {
+  for (int i = 0; i < count; ++i)
+    dst[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+#ifdef MOUNTAINS_X86
+MOUNTAINS_TARGET("sse2")
+void lerpSse2(double *dst, const double *a, const double *b, int count,
+              double t) {
+  const __m128d vt = _mm_set1_pd(t);
+  int i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d va = _mm_loadu_pd(a + i);
+    __m128d d = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(b + i), va), vt);
+    _mm_storeu_pd(dst + i, _mm_add_pd(va, d));
+  }
+  lerpScalar(dst + i, a + i, b + i, count - i, t);
+}
+
+MOUNTAINS_TARGET("avx2")
+void lerpAvx2(double *dst, const double *a, const double *b, int count,
+              double t) {
+  const __m256d vt = _mm256_set1_pd(t);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256d a0 = _mm256_loadu_pd(a + i), a1 = _mm256_loadu_pd(a + i + 4);
+    __m256d d0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(b + i), a0), vt);
+    __m256d d1 =
+        _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(b + i + 4), a1), vt);
+    _mm256_storeu_pd(dst + i, _mm256_add_pd(a0, d0));
+    _mm256_storeu_pd(dst + i + 4, _mm256_add_pd(a1, d1));
+  }
+  lerpScalar(dst + i, a + i, b + i, count - i, t);
+}
+#endif
+
+struct SampleKernels {
+  void (*lerp)(double *, const double *, const double *, int, double);
+  const char *isa;
+};
+
+SampleKernels pickKernels() {
+#ifdef MOUNTAINS_X86
+  if (cpu_has_avx2())
+    return {lerpAvx2, "avx2"};
+  if (cpu_has_sse2())
+    return {lerpSse2, "sse2"};
+#endif
+  return {lerpScalar, "scalar"};
+}
+
+const SampleKernels &kernels() {
+  static const SampleKernels k = pickKernels();
+  return k;
+}
+
+} // namespace
+
+void lerp_samples(double *dst, const double *a, const double *b, int count,
+                  double t) {
+  kernels().lerp(dst, a, b, count, t);
+}
+
+const char *sample_kernels_isa() { return kernels().isa; }
@@ -1,7 +1,14 @@
 #include "Scene.h"
+#include "ColorKernels.h"
+#include "MidpointDisplacement.h"
 #include "MountainParams.h"
+#include "Profiler.h"
+#include "SceneFile.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
 Scene::Scene(int width, int height, const MountainColorScheme &scheme)
     : width_(width), height_(height), scheme_(scheme) {}
 
@@ -29,35 +36,340 @@ Scene Scene::makeDefault(int width, int height, int mountainCount) {
 
 void Scene::addMountain(MountainParams params) {
   mountains_.emplace_back(std::move(params));
+  dirty_ = true;
 }
 
 void Scene::addLayer(std::unique_ptr<Layer> layer) {
   layers_.push_back(std::move(layer));
+  dirty_ = true;
 }
 
-void Scene::clearLayers() { layers_.clear(); }
+void Scene::clearLayers() {
+  layers_.clear();
+  dirty_ = true;
+}
+
+void Scene::setScheme(const MountainColorScheme &s) {
+  scheme_ = s;
+  skyRowsValid_ = false;
+  dirty_ = true;
+}
+
+void Scene::resize(int width, int height) {
+  if (width == width_ && height == height_)
+    return;
+  width_ = width;
+  height_ = height;
+  skyRowsValid_ = false;
+  frameCacheValid_ = false;
+  dirty_ = true;
+  for (auto &l : layers_)
+    l->resize(width, height);
+}
+
+void Scene::setCompositeMode(CompositeMode m) {
+  // Both modes produce the same image; only the cost differs.
+  composite_ = m;
+}
+
+void Scene::setRasterMode(RasterMode m) { raster_ = m; }
+
+void Scene::setAntiAliasing(bool on) {
+  if (on == antiAlias_)
+    return;
+  antiAlias_ = on;
+  dirty_ = true;
+}
+
+int Scene::mountainAt(int x, int y) const {
+  if (x < 0 || x >= width_ || y < 0 || y >= height_)
+    return -1;
+  std::vector<int16_t> scratch;
+  int nearest = -1, nearestDist = height_ + 1;
+  // Front to back: the first ridge whose top is at or above y is the one
+  // drawn there.
+  for (int i = int(mountains_.size()) - 1; i >= 0; --i) {
+    const Mountain &m = mountains_[size_t(i)];
+    const int16_t *tops = m.cachedSilhouette(width_, height_);
+    if (!tops) {
+      scratch.resize(size_t(width_));
+      m.columnTops(width_, height_, scratch.data());
+      tops = scratch.data();
+    }
+    int top = tops[x];
+    if (top <= y)
+      return i;
+    if (top - y < nearestDist) {
+      nearestDist = top - y;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+bool Scene::sculpt(int index, int x, int y, int radius) {
+  if (index < 0 || size_t(index) >= mountains_.size())
+    return false;
+  if (!mountains_[size_t(index)].sculpt(x, y, width_, height_, radius))
+    return false;
+  dirty_ = true;
+  return true;
+}
+
+std::vector<Mountain> &Scene::getMountains() {
+  dirty_ = true;
+  return mountains_;
+}
+
+bool Scene::isDirty() const {
+  return dirty_ || std::any_of(layers_.begin(), layers_.end(),
+                               [](const auto &l) { return l->isDirty(); });
+}
+
+void Scene::setFrameCacheEnabled(bool on) {
+  if (on == frameCacheEnabled_)
+    return;
+  frameCacheEnabled_ = on;
+  frameCacheValid_ = false;
+  if (!on) {
+    frameCache_.clear();
+    frameCache_.shrink_to_fit();
+  }
+}
+
+void Scene::setMorphing(double seconds) {
+  set_morphing(morpher_, seconds, mountains_);
+}
 
 void Scene::update(double dt) {
+  MOUNTAINS_PROFILE_SCOPE(SceneUpdate);
+  if (update_morphing(morpher_, mountains_, dt))
+    dirty_ = true;
   for (auto &l : layers_)
     l->update(dt);
 }
 
-void Scene::render(uint32_t *pixels, int rowStride) {
-  fill_sky_gradient(pixels, rowStride, width_, height_, scheme_.skyTop,
-                    scheme_.skyBottom);
-  RenderContext ctx{pixels, rowStride, width_, height_};
+void Scene::render(void *pixels, int rowStride, PixelFormat format) {
+  MOUNTAINS_PROFILE_SCOPE(SceneRender);
+  const size_t pixelBytes = size_t(pixel_format_bytes(format));
+  const size_t rowBytes = size_t(width_) * pixelBytes;
+  auto *bytes = static_cast<uint8_t *>(pixels);
+  bool dirty = isDirty();
+  if (!dirty && frameCacheValid_ && frameCacheFormat_ == format) {
+    for (int y = 0; y < height_; ++y)
+      std::memcpy(bytes + size_t(y) * rowStride * pixelBytes,
+                  frameCache_.data() + size_t(y) * rowBytes, rowBytes);
+    return;
+  }
+
+  renderFrame(pixels, rowStride, format);
+
+  dirty_ = false;
   for (auto &l : layers_)
-    l->render(ctx);
-  for (const auto &m : mountains_)
-    m.paint(pixels, rowStride, width_, height_);
+    l->clearDirty();
+  if (frameCacheEnabled_) {
+    frameCache_.resize(rowBytes * size_t(height_));
+    for (int y = 0; y < height_; ++y)
+      std::memcpy(frameCache_.data() + size_t(y) * rowBytes,
+                  bytes + size_t(y) * rowStride * pixelBytes, rowBytes);
+    frameCacheFormat_ = format;
+    frameCacheValid_ = true;
+  }
 }
 
-void Scene::clearMountains() { mountains_.clear(); }
+void Scene::renderFrame(void *pixels, int rowStride, PixelFormat format) {
+  updateSkyRows();
+  const bool frontToBack =
+      composite_ == CompositeMode::FrontToBack && !antiAlias_ &&
+      std::all_of(layers_.begin(), layers_.end(),
+                  [](const auto &l) { return l->supportsFrontToBack(); });
 
-void Scene::setMountains(std::vector<MountainParams> paramsList) {
+  // Silhouettes are shared by every band and cached per mountain; only a
+  // new size or new ridges cost anything here.
+  auto prepareSilhouette = [&](int i) {
+    mountains_[size_t(i)].silhouette(width_, height_);
+  };
+  if (pool_)
+    pool_->parallelFor(int(mountains_.size()), prepareSilhouette);
+  else
+    for (int i = 0; i < int(mountains_.size()); ++i)
+      prepareSilhouette(i);
+  for (auto &l : layers_)
+    l->prepare(width_, height_);
+
+  // A few bands per thread lets work stealing even out bands that cross
+  // more ridges than others.
+  int bands = pool_ ? std::min(height_, pool_->concurrency() * 4) : 1;
+  int bandH = (height_ + bands - 1) / std::max(1, bands);
+  bands = (height_ + bandH - 1) / bandH;
+  if (bandScratch_.size() < size_t(bands))
+    bandScratch_.resize(size_t(bands));
+  auto renderOne = [&](int b) {
+    int y0 = b * bandH;
+    int y1 = std::min(height_, y0 + bandH);
+    renderBand(pixels, rowStride, format, 0, y0, width_, y1, frontToBack,
+               bandScratch_[size_t(b)]);
+  };
+  if (pool_ && bands > 1)
+    pool_->parallelFor(bands, renderOne);
+  else
+    for (int b = 0; b < bands; ++b)
+      renderOne(b);
+}
+
+// Render the clip rectangle [x0, x1) x [y0, y1). With 'frontToBack' this is
+// the same image as the painter path but walked nearest-first: scene
+// mountains (front to back), then layers in reverse order, then the sky fills
+// whatever is still uncovered.
+void Scene::renderBand(void *pixels, int rowStride, PixelFormat format,
+                       int x0, int y0, int x1, int y1, bool frontToBack,
+                       BandScratch &scratch) {
+  const bool spans = raster_ == RasterMode::Spans;
+  const size_t w = size_t(width_);
+  RenderContext ctx{pixels, rowStride, width_, height_};
+  ctx.raster = spans ? &scratch.raster : nullptr;
+  ctx.antiAlias = antiAlias_;
+  ctx.clipX0 = x0;
+  ctx.clipY0 = y0;
+  ctx.clipX1 = x1;
+  ctx.clipY1 = y1;
+  ctx.format = format;
+
+  if (!frontToBack) {
+    with_pixel_format(format, [&](auto traits) {
+      using Pixel = typename decltype(traits)::Pixel;
+      const Pixel *sky =
+          pack_rows<decltype(traits)>(skyRows_.data(), y0, y1);
+      fill_gradient_rows(static_cast<Pixel *>(pixels), rowStride, x0, x1, y0,
+                         y1, sky);
+    });
+    for (auto &l : layers_) {
+      MOUNTAINS_PROFILE_SCOPE(LayerRender);
+      l->render(ctx);
+    }
+    for (const auto &m : mountains_)
+      m.render(ctx);
+    return;
+  }
+
+  scratch.coverage.assign(w, static_cast<int16_t>(y1));
+  ctx.coverage = scratch.coverage.data();
+  for (auto it = mountains_.rbegin(); it != mountains_.rend(); ++it)
+    it->render(ctx);
+  for (auto it = layers_.rbegin(); it != layers_.rend(); ++it) {
+    MOUNTAINS_PROFILE_SCOPE(LayerRender);
+    (*it)->render(ctx);
+  }
+  if (spans) {
+    scratch.zeros.assign(w, 0);
+    scratch.raster.build(scratch.zeros.data(), ctx.coverage, width_, height_,
+                         x0, y0, x1, y1);
+  }
+  with_pixel_format(format, [&](auto traits) {
+    using Pixel = typename decltype(traits)::Pixel;
+    Pixel *out = static_cast<Pixel *>(pixels);
+    const Pixel *sky = pack_rows<decltype(traits)>(skyRows_.data(), y0, y1);
+    if (spans)
+      scratch.raster.fill(out, rowStride, sky);
+    else
+      fill_rows_occluded(out, rowStride, x0, y0, x1, sky, ctx.coverage);
+  });
+}
+
+void Scene::setThreadPool(std::shared_ptr<ThreadPool> pool) {
+  pool_ = std::move(pool);
+}
+
+// The sky gradient only depends on the scheme and the height, so its row
+// colors are the whole background and are computed once per scheme.
+void Scene::updateSkyRows() {
+  if (skyRowsValid_ && skyRows_.size() == size_t(height_))
+    return;
+  skyRowsValid_ = true;
+  skyRows_.resize(size_t(height_));
+  gradient_rows(skyRows_.data(), height_, scheme_.skyTop, scheme_.skyBottom);
+}
+
+void Scene::clearMountains() {
   mountains_.clear();
-  mountains_.reserve(paramsList.size());
-  for (auto &p : paramsList) {
-    mountains_.emplace_back(std::move(p));
+  dirty_ = true;
+}
+
+void Scene::setMountains(std::vector<MountainParams> paramsList) {
+  buildMountains(std::move(paramsList));
+}
+
+bool Scene::buildMountains(std::vector<MountainParams> paramsList,
+                           uint64_t sceneSeed, const BuildProgress &progress) {
+  const size_t total = paramsList.size();
+  std::vector<Mountain> built;
+  built.swap(spareMountains_);
+  if (built.size() > total)
+    built.erase(built.begin() + std::ptrdiff_t(total), built.end());
+  built.reserve(total);
+  for (size_t i = 0; i < total; ++i) {
+    if (sceneSeed != 0)
+      paramsList[i].seed = uint32_t(ridge_seed(sceneSeed, i) >> 32);
+    if (i < built.size())
+      built[i].reset(std::move(paramsList[i]), false);
+    else
+      built.emplace_back(std::move(paramsList[i]), false);
   }
+
+  std::atomic<bool> cancelled{false};
+  std::mutex progressMutex;
+  size_t done = 0;
+  auto generateOne = [&](int i) {
+    if (cancelled.load(std::memory_order_relaxed))
+      return;
+    built[size_t(i)].generate(pool_.get());
+    if (!progress)
+      return;
+    std::lock_guard<std::mutex> lk(progressMutex);
+    if (!cancelled.load(std::memory_order_relaxed) && !progress(++done, total))
+      cancelled.store(true, std::memory_order_relaxed);
+  };
+  if (pool_)
+    pool_->parallelFor(int(total), generateOne);
+  else
+    for (int i = 0; i < int(total); ++i)
+      generateOne(i);
+  if (cancelled.load()) {
+    spareMountains_ = std::move(built);
+    return false;
+  }
+
+  // The replaced mountains are freed: spares come only from recycle().
+  mountains_.swap(built);
+  dirty_ = true;
+  return true;
+}
+
+void Scene::recycle(Scene &&retired) {
+  for (auto *list : {&retired.mountains_, &retired.spareMountains_})
+    for (Mountain &m : *list)
+      spareMountains_.push_back(std::move(m));
+  retired.mountains_.clear();
+  retired.spareMountains_.clear();
+  if (bandScratch_.empty())
+    bandScratch_ = std::move(retired.bandScratch_);
+  if (frameCache_.capacity() == 0) {
+    frameCache_ = std::move(retired.frameCache_);
+    frameCache_.clear();
+  }
+  if (skyRows_.capacity() == 0) {
+    skyRows_ = std::move(retired.skyRows_);
+    skyRowsValid_ = false;
+  }
+}
+
+bool Scene::save(const std::string &path, bool withSamples,
+                 std::string *error) const {
+  return write_scene_file(*this, path, withSamples, error);
+}
+
+std::unique_ptr<Scene> Scene::load(const std::string &path,
+                                   std::shared_ptr<ThreadPool> pool,
+                                   std::string *error) {
+  return read_scene_file(path, std::move(pool), error);
 }
@@ -0,0 +1,392 @@
+#include "SceneFile.h"
+#include "MidpointDisplacement.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MOUNTAINS_HAVE_MMAP 1
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'M', 'T', 'N', 'S', 'C', 'E', 'N', 'E'};
+constexpr size_t kPyramidAlign = 64;
+
+bool fail(std::string *error, const std::string &what) {
+  if (error)
+    *error = what;
+  return false;
+}
+
+bool littleEndian() {
+  const uint32_t one = 1;
+  uint8_t first;
+  std::memcpy(&first, &one, 1);
+  return first == 1;
+}
+
+size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+inline uint64_t rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+// A read-only view of a whole file: mapped where the platform can, else read
+// into memory aligned for doubles.
+class FileView {
+public:
+  static std::shared_ptr<FileView> open(const std::string &path,
+                                        std::string *error) {
+    auto view = std::shared_ptr<FileView>(new FileView());
+#ifdef MOUNTAINS_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      fail(error, "cannot open " + path);
+      return nullptr;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+      ::close(fd);
+      fail(error, "cannot read " + path);
+      return nullptr;
+    }
+    view->size_ = size_t(st.st_size);
+    void *p = ::mmap(nullptr, view->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      fail(error, "cannot map " + path);
+      return nullptr;
+    }
+#ifdef MADV_WILLNEED
+    ::madvise(p, view->size_, MADV_WILLNEED);
+#endif
+    view->mapping_ = p;
+    view->data_ = static_cast<const uint8_t *>(p);
+#else
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+      fail(error, "cannot open " + path);
+      return nullptr;
+    }
+    std::fseek(f, 0, SEEK_END);
+    long size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    if (size > 0) {
+      view->size_ = size_t(size);
+      view->buffer_.resize((view->size_ + 7) / 8);
+      if (std::fread(view->buffer_.data(), 1, view->size_, f) != view->size_)
+        size = 0;
+    }
+    std::fclose(f);
+    if (size <= 0) {
+      fail(error, "cannot read " + path);
+      return nullptr;
+    }
+    view->data_ = reinterpret_cast<const uint8_t *>(view->buffer_.data());
+#endif
+    return view;
+  }
+
+  ~FileView() {
+#ifdef MOUNTAINS_HAVE_MMAP
+    if (mapping_)
+      ::munmap(mapping_, size_);
+#endif
+  }
+  FileView(const FileView &) = delete;
+  FileView &operator=(const FileView &) = delete;
+
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  FileView() = default;
+
+  const uint8_t *data_ = nullptr;
+  size_t size_ = 0;
+  void *mapping_ = nullptr;
+  std::vector<uint64_t> buffer_;
+};
+
+// The checksum only proves the file is what was written; what was written
+// still has to make a ridge.
+bool validRecord(const SceneFileMountain &m) {
+  for (double v : {m.leftHeight, m.rightHeight, m.initialDisplacement,
+                   m.roughness, m.minHeight, m.maxHeight, m.verticalSpan,
+                   m.fogStrength})
+    if (!std::isfinite(v))
+      return false;
+  return m.width >= 2 && m.width <= kSceneFileMaxRidgeWidth &&
+         m.minHeight <= m.maxHeight && m.verticalSpan > 0.0 &&
+         m.verticalSpan <= 1.0 && m.roughness > 0.0 && m.roughness < 1.5 &&
+         m.fogStrength >= 0.0 && m.fogStrength <= 1.0 &&
+         m.algorithm <= uint8_t(RidgeAlgorithm::FbmNoise);
+}
+
+// scene_file_checksum(), which also reports in 'finite' whether every whole
+// 8-byte word from offset 'finiteFrom' on is a finite double: pyramids are
+// used as they lie in the file, so that is the one pass over their bytes.
+uint64_t checksum(const uint8_t *data, size_t size, size_t finiteFrom,
+                  bool *finite) {
+  constexpr uint64_t P1 = 0x9E3779B185EBCA87ull, P2 = 0xC2B2AE3D27D4EB4Full;
+  constexpr uint64_t kExponent = 0x7FF0000000000000ull; // all ones: NaN, inf
+  uint64_t lane[4] = {P1 + P2, P2, 0, 0 - P1};
+  bool nonFinite = false;
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32)
+    for (int k = 0; k < 4; ++k) {
+      uint64_t w;
+      std::memcpy(&w, data + i + 8 * k, 8);
+      lane[k] = rotl(lane[k] + w * P2, 31) * P1;
+      nonFinite |= (w & kExponent) == kExponent && i + 8 * k >= finiteFrom;
+    }
+  for (size_t j = std::max(i, finiteFrom); j + 8 <= size; j += 8) {
+    uint64_t w;
+    std::memcpy(&w, data + j, 8);
+    nonFinite |= (w & kExponent) == kExponent;
+  }
+  *finite = !nonFinite;
+  uint64_t h = rotl(lane[0], 1) + rotl(lane[1], 7) + rotl(lane[2], 12) +
+               rotl(lane[3], 18) + uint64_t(size);
+  for (; i < size; ++i)
+    h = rotl(h ^ (data[i] * P1), 11) * P2;
+  return mix64(h);
+}
+
+} // namespace
+
+uint64_t scene_file_checksum(const uint8_t *data, size_t size) {
+  bool finite;
+  return checksum(data, size, size, &finite);
+}
+
+bool write_scene_file(const Scene &scene, const std::string &path,
+                      bool withPyramids, std::string *error) {
+  if (!littleEndian())
+    return fail(error, "scene files need a little-endian host");
+  const auto &mountains = scene.getMountains();
+  const size_t count = mountains.size();
+
+  std::string names;
+  for (const auto &m : mountains)
+    names += m.params().name;
+  size_t end = sizeof(SceneFileHeader) + count * sizeof(SceneFileMountain) +
+               names.size();
+
+  std::vector<SceneFileMountain> records(count);
+  size_t nameOffset = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const MountainParams &p = mountains[i].params();
+    SceneFileMountain &r = records[i];
+    std::memset(&r, 0, sizeof(r));
+    r.leftHeight = p.leftHeight;
+    r.rightHeight = p.rightHeight;
+    r.initialDisplacement = p.initialDisplacement;
+    r.roughness = p.roughness;
+    r.minHeight = p.minHeight;
+    r.maxHeight = p.maxHeight;
+    r.verticalSpan = p.verticalSpan;
+    r.fogStrength = p.fogStrength;
+    r.width = p.width;
+    r.seed = p.seed;
+    r.verticalOffset = p.verticalOffset;
+    r.colorARGB = p.colorARGB;
+    r.fogColor = p.fogColor;
+    r.algorithm = uint8_t(p.algorithm);
+    r.nameOffset = uint32_t(nameOffset);
+    r.nameLength = uint32_t(p.name.size());
+    nameOffset += p.name.size();
+    const HeightPyramid &pyr = mountains[i].pyramid();
+    if (withPyramids && pyr.size() > 0) {
+      end = alignUp(end, kPyramidAlign);
+      r.pyramidOffset = end;
+      r.pyramidCount = pyr.storageSize();
+      end += r.pyramidCount * sizeof(double);
+    }
+  }
+
+  std::vector<uint8_t> file(end, 0);
+  SceneFileHeader h;
+  std::memset(&h, 0, sizeof(h));
+  std::memcpy(h.magic, kMagic, sizeof(kMagic));
+  h.version = kSceneFileVersion;
+  h.flags = withPyramids ? kSceneFileHasPyramids : 0;
+  h.width = scene.width();
+  h.height = scene.height();
+  h.mountainCount = uint32_t(count);
+  h.recordSize = sizeof(SceneFileMountain);
+  h.fileSize = end;
+  h.skyTop = scene.scheme().skyTop;
+  h.skyBottom = scene.scheme().skyBottom;
+  h.fogColor = scene.scheme().fogColor;
+  h.sunColor = scene.scheme().sunColor;
+
+  uint8_t *out = file.data() + sizeof(h);
+  if (count > 0)
+    std::memcpy(out, records.data(), count * sizeof(SceneFileMountain));
+  out += count * sizeof(SceneFileMountain);
+  std::memcpy(out, names.data(), names.size());
+  for (size_t i = 0; i < count; ++i)
+    if (records[i].pyramidOffset)
+      std::memcpy(file.data() + records[i].pyramidOffset,
+                  mountains[i].pyramid().storage(),
+                  records[i].pyramidCount * sizeof(double));
+  h.checksum = scene_file_checksum(file.data() + sizeof(h), end - sizeof(h));
+  std::memcpy(file.data(), &h, sizeof(h));
+
+  FILE *f = std::fopen(path.c_str(), "wb");
+  if (!f)
+    return fail(error, "cannot create " + path);
+  bool ok = std::fwrite(file.data(), 1, file.size(), f) == file.size();
+  if (std::fclose(f) != 0 || !ok)
+    return fail(error, "cannot write " + path);
+  return true;
+}
+
+std::unique_ptr<Scene> read_scene_file(const std::string &path,
+                                       std::shared_ptr<ThreadPool> pool,
+                                       std::string *error) {
+  if (!littleEndian()) {
+    fail(error, "scene files need a little-endian host");
+    return nullptr;
+  }
+  std::shared_ptr<FileView> view = FileView::open(path, error);
+  if (!view)
+    return nullptr;
+  const uint8_t *base = view->data();
+  const size_t size = view->size();
+
+  SceneFileHeader h;
+  if (size < sizeof(h)) {
+    fail(error, path + ": not a scene file");
+    return nullptr;
+  }
+  std::memcpy(&h, base, sizeof(h));
+  if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+    fail(error, path + ": not a scene file");
+    return nullptr;
+  }
+  if (h.version != kSceneFileVersion ||
+      h.recordSize != sizeof(SceneFileMountain)) {
+    fail(error, path + ": unsupported scene file version " +
+                    std::to_string(h.version));
+    return nullptr;
+  }
+  const size_t namesStart =
+      sizeof(h) + size_t(h.mountainCount) * sizeof(SceneFileMountain);
+  if (h.fileSize != size || namesStart > size || h.width < 2 ||
+      h.height < 2) {
+    fail(error, path + ": truncated or damaged");
+    return nullptr;
+  }
+  if (h.width > kSceneFileMaxSide || h.height > kSceneFileMaxSide) {
+    fail(error, path + ": scene too large");
+    return nullptr;
+  }
+  // Pyramids follow the records and names, so every word from the first
+  // one on has to be a finite height (or zero padding).
+  const auto *records = base + sizeof(h);
+  size_t pyramidsStart = size;
+  for (uint32_t i = 0; i < h.mountainCount; ++i) {
+    uint64_t offset;
+    std::memcpy(&offset,
+                records + size_t(i) * sizeof(SceneFileMountain) +
+                    offsetof(SceneFileMountain, pyramidOffset),
+                sizeof(offset));
+    if (offset != 0 && offset < pyramidsStart)
+      pyramidsStart = size_t(offset);
+  }
+  bool finite;
+  if (checksum(base + sizeof(h), size - sizeof(h),
+               std::max(pyramidsStart, namesStart) - sizeof(h),
+               &finite) != h.checksum) {
+    fail(error, path + ": checksum mismatch");
+    return nullptr;
+  }
+  if (!finite) {
+    fail(error, path + ": non-finite pyramid heights");
+    return nullptr;
+  }
+
+  MountainColorScheme scheme;
+  scheme.skyTop = h.skyTop;
+  scheme.skyBottom = h.skyBottom;
+  scheme.fogColor = h.fogColor;
+  scheme.sunColor = h.sunColor;
+  auto scene = std::make_unique<Scene>(h.width, h.height, scheme);
+  scene->setThreadPool(std::move(pool));
+
+  std::vector<MountainParams> params(h.mountainCount);
+  std::vector<const double *> pyramids(h.mountainCount, nullptr);
+  uint64_t totalSamples = 0;
+  for (uint32_t i = 0; i < h.mountainCount; ++i) {
+    SceneFileMountain r;
+    std::memcpy(&r, records + size_t(i) * sizeof(r), sizeof(r));
+    const size_t samples = size_t(std::max(3, r.width));
+    const bool namesOk =
+        uint64_t(namesStart) + r.nameOffset + r.nameLength <= size;
+    const bool pyramidOk =
+        r.pyramidOffset == 0 ||
+        (r.pyramidOffset % alignof(double) == 0 &&
+         r.pyramidOffset >= namesStart &&
+         r.pyramidCount == HeightPyramid::storageSize(int(samples)) &&
+         r.pyramidOffset <= size &&
+         r.pyramidCount <= (size - r.pyramidOffset) / sizeof(double));
+    if (!validRecord(r) || !namesOk || !pyramidOk) {
+      fail(error, path + ": bad mountain record " + std::to_string(i));
+      return nullptr;
+    }
+    totalSamples += samples;
+    if (totalSamples > kSceneFileMaxSamples) {
+      fail(error, path + ": scene too large");
+      return nullptr;
+    }
+    MountainParams &p = params[i];
+    p.width = r.width;
+    p.seed = r.seed;
+    p.leftHeight = r.leftHeight;
+    p.rightHeight = r.rightHeight;
+    p.initialDisplacement = r.initialDisplacement;
+    p.roughness = r.roughness;
+    p.minHeight = r.minHeight;
+    p.maxHeight = r.maxHeight;
+    p.verticalSpan = r.verticalSpan;
+    p.verticalOffset = r.verticalOffset;
+    p.colorARGB = r.colorARGB;
+    p.fogStrength = r.fogStrength;
+    p.fogColor = r.fogColor;
+    p.algorithm = RidgeAlgorithm(r.algorithm);
+    p.name.assign(reinterpret_cast<const char *>(base + namesStart) +
+                      r.nameOffset,
+                  r.nameLength);
+    if (r.pyramidOffset)
+      pyramids[i] = reinterpret_cast<const double *>(base + r.pyramidOffset);
+  }
+
+  // Stored pyramids are used where they lie in the file. A file saved
+  // without them generates its ridges instead; random-access ridges never
+  // store one and cost nothing to set up.
+  if (!(h.flags & kSceneFileHasPyramids)) {
+    scene->buildMountains(std::move(params));
+    return scene;
+  }
+  std::vector<Mountain> mountains;
+  mountains.reserve(params.size());
+  for (size_t i = 0; i < params.size(); ++i) {
+    mountains.emplace_back(std::move(params[i]), false);
+    if (pyramids[i])
+      mountains.back().adoptPyramid(pyramids[i], view);
+    else
+      mountains.back().generate();
+  }
+  scene->getMountains() = std::move(mountains);
+  return scene;
+}
@@ -0,0 +1,136 @@
+#include "ScenePresets.h"
+#include "MidpointDisplacement.h"
+#include "RenderUtils.h"
+#include <algorithm>
+
+namespace {
+// Per-ridge SplitMix64 stream. Unlike std::uniform_real_distribution its
+// values are the same on every standard library.
+struct RidgeRandom {
+  uint64_t state;
+  uint64_t next() { return mix64(state += 0x9E3779B97F4A7C15ull); }
+  double uniform() { return double(next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+} // namespace
+
+MountainColorScheme getNordScheme() {
+  MountainColorScheme s;
+  s.skyTop = 0xFF2E3440u;
+  s.skyBottom = 0xFFD8DEE9u;
+  s.fogColor = lerpColor(s.skyBottom, 0xFF88C0D0u, 0.07);
+  s.sunColor = 0xFF8FBCBBu;
+  return s;
+}
+
+MountainColorScheme getEverforestScheme() {
+  MountainColorScheme s;
+  s.skyTop = 0xFF1E2326u;
+  s.skyBottom = 0xFFE67E80u;
+  s.fogColor = 0x00D8DEE9u;
+  s.sunColor = 0xFFF6E9B3u;
+  return s;
+}
+
+const std::vector<uint32_t> NORD_PALETTE = {
+    0xFF2E3440u, 0xFF3B4252u, 0xFF434C5Eu, 0xFF4C566Au,
+    0xFFD8DEE9u, 0xFF8FBCBBu, 0xFF88C0D0u, 0xFF81A1C1u};
+const std::vector<uint32_t> EVER_PALETTE = {
+    0xFF1B3B2Bu, 0xFF2A5B3Au, 0xFF3B7B49u, 0xFF4C9B58u, 0xFF6BBA6Bu};
+
+std::vector<MountainParams>
+makeRandomMountainsWithPalette(size_t count, int winW,
+                               const std::vector<uint32_t> &palette,
+                               const MountainColorScheme &scheme,
+                               uint64_t sceneSeed) {
+  std::vector<MountainParams> out;
+  out.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    RidgeRandom rng{ridge_seed(sceneSeed, i)};
+    double t = double(i) / double(std::max<size_t>(1, count - 1));
+    MountainParams p;
+    p.width = winW;
+    p.seed = uint32_t(rng.state >> 32);
+    p.leftHeight = 0.05 + 0.15 * rng.uniform() + 0.06 * t;
+    p.rightHeight = 0.05 + 0.15 * rng.uniform() + 0.06 * t;
+    p.initialDisplacement = 0.5 + 0.9 * rng.uniform() + 0.4 * t;
+    p.roughness = 0.48;
+    p.minHeight = 0;
+    p.maxHeight = 1.5 - t;
+    p.verticalSpan = 0.5 + 0.45 * t;
+    p.verticalOffset = static_cast<int>(30.0 * (1.0 + t));
+
+    uint32_t baseColor;
+    if (!palette.empty()) {
+      size_t idx = std::min<size_t>(i, palette.size() - 1);
+      baseColor = palette[idx];
+    } else {
+      uint8_t g = uint8_t(30 + (rng.next() % 140));
+      baseColor = packARGB(0xFF, g, g, g);
+    }
+
+    // Farther ridges sit deeper in the haze.
+    p.colorARGB = baseColor;
+    p.fogColor = scheme.fogColor;
+    p.fogStrength = 0.45 * (1.0 - t);
+
+    out.push_back(std::move(p));
+  }
+  return out;
+}
+
+std::vector<MountainParams>
+makeRandomMountainsNord(size_t count, int winW,
+                        const MountainColorScheme &scheme, uint64_t sceneSeed) {
+  return makeRandomMountainsWithPalette(count, winW, NORD_PALETTE, scheme,
+                                        sceneSeed);
+}
+
+std::vector<MountainParams>
+makeRandomMountainsEverforest(size_t count, int winW,
+                              const MountainColorScheme &scheme,
+                              uint64_t sceneSeed) {
+  return makeRandomMountainsWithPalette(count, winW, EVER_PALETTE, scheme,
+                                        sceneSeed);
+}
+
+MountainParams makeRandomTerrain(int size, uint64_t sceneSeed) {
+  RidgeRandom rng{ridge_seed(sceneSeed, 0)};
+  MountainParams p;
+  p.width = size;
+  p.seed = uint32_t(rng.state >> 32);
+  p.leftHeight = 0.1 + 0.3 * rng.uniform();
+  p.rightHeight = 0.1 + 0.3 * rng.uniform();
+  p.initialDisplacement = 0.6 + 0.6 * rng.uniform();
+  p.roughness = 0.55;
+  return p;
+}
+
+std::vector<MountainParams>
+makeTerrainSlices(size_t count, const std::vector<uint32_t> &palette,
+                  const MountainColorScheme &scheme) {
+  std::vector<MountainParams> out;
+  out.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    double t = double(i) / double(std::max<size_t>(1, count - 1));
+    // Depth 3 at the back to 1 at the front; the ground line climbs toward
+    // the horizon and heights shrink as 1 / depth. Band horizons rarely dip
+    // below mid-height, so the lower part of the range sits below ground.
+    double depth = 3.0 - 2.0 * t;
+    double ground = 0.6 * (1.0 - 1.0 / depth);
+    MountainParams p;
+    p.minHeight = ground - 0.5 / depth;
+    p.maxHeight = ground + 0.5 / depth;
+    p.verticalSpan = 1.0;
+    p.verticalOffset = 0;
+    if (!palette.empty()) {
+      p.colorARGB = palette[std::min<size_t>(i, palette.size() - 1)];
+    } else {
+      uint8_t g = uint8_t(150 - 110 * t);
+      p.colorARGB = packARGB(0xFF, g, g, g);
+    }
+    p.fogColor = scheme.fogColor;
+    p.fogStrength = 0.45 * (1.0 - t);
+    out.push_back(std::move(p));
+  }
+  return out;
+}
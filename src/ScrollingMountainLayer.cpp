@@ -0,0 +1,89 @@
+#include "ScrollingMountainLayer.h"
+#include "Mountain.h"
+#include <algorithm>
+#include <cmath>
+
+ScrollingMountainLayer::ScrollingMountainLayer(
+    std::vector<MountainParams> ridges, double speed, int winW, int winH,
+    int chunkLevels)
+    : speed_(speed), winW_(std::max(1, winW)), winH_(std::max(1, winH)) {
+  ridges_.reserve(ridges.size());
+  for (auto &p : ridges) {
+    // Enough chunks for one window of samples plus the one scrolling in.
+    int span = 1 << std::clamp(chunkLevels, 1, 20);
+    int cache = (p.width + span - 1) / span + 2;
+    ridges_.emplace_back(std::move(p), chunkLevels, cache);
+  }
+  refreshTops();
+  refreshRowColors();
+}
+
+void ScrollingMountainLayer::setPosition(double position) {
+  position_ = position;
+  if (int64_t(std::floor(position_)) != topsFirst_) {
+    refreshTops();
+    markDirty();
+  }
+}
+
+void ScrollingMountainLayer::resize(int winW, int winH) {
+  winW_ = std::max(1, winW);
+  winH_ = std::max(1, winH);
+  refreshTops();
+  refreshRowColors();
+  markDirty();
+}
+
+void ScrollingMountainLayer::update(double dt) {
+  setPosition(position_ + speed_ * dt);
+}
+
+void ScrollingMountainLayer::refreshTops() {
+  topsFirst_ = int64_t(std::floor(position_));
+  tops_.resize(ridges_.size() * size_t(winW_));
+  for (size_t i = 0; i < ridges_.size(); ++i)
+    ridges_[i].columnTops(topsFirst_, winW_, winH_,
+                          tops_.data() + i * size_t(winW_));
+}
+
+void ScrollingMountainLayer::refreshRowColors() {
+  rowColors_.resize(ridges_.size() * size_t(winH_));
+  fogged_.assign(ridges_.size(), false);
+  for (size_t i = 0; i < ridges_.size(); ++i)
+    fogged_[i] = mountain_row_colors(ridges_[i].params(), winH_,
+                                     rowColors_.data() + i * size_t(winH_));
+}
+
+void ScrollingMountainLayer::render(const RenderContext &ctx) {
+  const size_t n = ridges_.size();
+  const bool resample = ctx.winW != winW_ || ctx.winH != winH_;
+  thread_local std::vector<int16_t> scratch;
+  auto topsOf = [&](size_t i) -> const int16_t * {
+    const int16_t *t = tops_.data() + i * size_t(winW_);
+    if (!resample)
+      return t;
+    scratch.resize(size_t(ctx.winW));
+    for (int x = 0; x < ctx.winW; ++x) {
+      int sx = int(int64_t(x) * winW_ / ctx.winW);
+      scratch[size_t(x)] = static_cast<int16_t>(int64_t(t[sx]) * ctx.winH /
+                                                winH_);
+    }
+    return scratch.data();
+  };
+  thread_local std::vector<uint32_t> rowScratch;
+  auto rowsOf = [&](size_t i) -> const uint32_t * {
+    if (!fogged_[i])
+      return nullptr;
+    if (!resample)
+      return rowColors_.data() + i * size_t(winH_);
+    rowScratch.resize(size_t(ctx.winH));
+    mountain_row_colors(ridges_[i].params(), ctx.winH, rowScratch.data());
+    return rowScratch.data();
+  };
+  // Ridges are stored back to front; front to back walks them reversed.
+  for (size_t k = 0; k < n; ++k) {
+    size_t i = ctx.coverage ? n - 1 - k : k;
+    render_silhouette(ctx, topsOf(i), ridges_[i].params().colorARGB,
+                      rowsOf(i));
+  }
+}
@@ -0,0 +1,296 @@
+#include "SpanRaster.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define MOUNTAINS_X86 1
+#endif
+
+#if defined(MOUNTAINS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MOUNTAINS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MOUNTAINS_TARGET(isa)
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static inline int ctz64(uint64_t v) {
+  unsigned long idx;
+  _BitScanForward64(&idx, v);
+  return int(idx);
+}
+#else
+static inline int ctz64(uint64_t v) { return __builtin_ctzll(v); }
+#endif
+
+namespace {
+
+// The kernels are shared by 32- and 16-bit pixels: vector stores of the
+// value splatted to 32 bits, element counts in T.
+template <class T> void fillScalar(T *dst, int count, T value) {
+  std::fill_n(dst, count, value);
+}
+
+template <class T> uint32_t splat32(T value) {
+  return sizeof(T) == 2 ? uint32_t(value) * 0x10001u : uint32_t(value);
+}
+
+#ifdef MOUNTAINS_X86
+template <class T>
+MOUNTAINS_TARGET("sse2")
+void fillSse2(T *dst, int count, T value) {
+  constexpr int kLanes = int(16 / sizeof(T));
+  while (count > 0 && (reinterpret_cast<uintptr_t>(dst) & 15u)) {
+    *dst++ = value;
+    --count;
+  }
+  const __m128i v = _mm_set1_epi32(int(splat32(value)));
+  for (; count >= 2 * kLanes; count -= 2 * kLanes, dst += 2 * kLanes) {
+    _mm_store_si128(reinterpret_cast<__m128i *>(dst), v);
+    _mm_store_si128(reinterpret_cast<__m128i *>(dst + kLanes), v);
+  }
+  if (count >= kLanes) {
+    _mm_store_si128(reinterpret_cast<__m128i *>(dst), v);
+    dst += kLanes;
+    count -= kLanes;
+  }
+  while (count-- > 0)
+    *dst++ = value;
+}
+
+template <class T>
+MOUNTAINS_TARGET("avx2")
+void fillAvx2(T *dst, int count, T value) {
+  constexpr int kLanes = int(32 / sizeof(T));
+  if (count < kLanes) {
+    while (count-- > 0)
+      *dst++ = value;
+    return;
+  }
+  const __m256i v = _mm256_set1_epi32(int(splat32(value)));
+  // One unaligned store covers the head, then continue aligned.
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+  int skip = int((32u - (reinterpret_cast<uintptr_t>(dst) & 31u)) & 31u) /
+             int(sizeof(T));
+  dst += skip;
+  count -= skip;
+  for (; count >= 2 * kLanes; count -= 2 * kLanes, dst += 2 * kLanes) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(dst), v);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(dst + kLanes), v);
+  }
+  if (count >= kLanes) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(dst), v);
+    dst += kLanes;
+    count -= kLanes;
+  }
+  // Unaligned tail store ending exactly at the span end.
+  if (count > 0)
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + count - kLanes), v);
+}
+#endif
+
+template <class T> struct FillKernel {
+  void (*fn)(T *, int, T);
+  const char *isa;
+};
+
+template <class T> FillKernel<T> pickFill() {
+#ifdef MOUNTAINS_X86
+  if (cpu_has_avx2())
+    return {fillAvx2<T>, "avx2"};
+  if (cpu_has_sse2())
+    return {fillSse2<T>, "sse2"};
+#endif
+  return {fillScalar<T>, "scalar"};
+}
+
+template <class T> const FillKernel<T> &fillKernel() {
+  static const FillKernel<T> k = pickFill<T>();
+  return k;
+}
+
+template <class T>
+void fillRows(const SpanRasterizer &r, T *pixels, int rowStride, T color) {
+  for (int y = r.firstRow(); y < r.endRow(); ++y) {
+    T *row = pixels + size_t(y) * rowStride;
+    for (const RowSpan *s = r.rowBegin(y), *e = r.rowEnd(y); s != e; ++s)
+      fill_span(row + s->x0, s->x1 - s->x0, color);
+  }
+}
+
+template <class T>
+void fillRows(const SpanRasterizer &r, T *pixels, int rowStride,
+              const T *rowColors) {
+  for (int y = r.firstRow(); y < r.endRow(); ++y) {
+    T *row = pixels + size_t(y) * rowStride;
+    T color = rowColors[y];
+    for (const RowSpan *s = r.rowBegin(y), *e = r.rowEnd(y); s != e; ++s)
+      fill_span(row + s->x0, s->x1 - s->x0, color);
+  }
+}
+
+} // namespace
+
+void fill_span(uint32_t *dst, int count, uint32_t value) {
+  fillKernel<uint32_t>().fn(dst, count, value);
+}
+
+void fill_span(uint16_t *dst, int count, uint16_t value) {
+  fillKernel<uint16_t>().fn(dst, count, value);
+}
+
+const char *fill_span_isa() { return fillKernel<uint32_t>().isa; }
+
+int16_t *SpanRasterizer::columnScratch(int winW) {
+  if (int(scratch_.size()) < winW)
+    scratch_.resize(size_t(winW));
+  return scratch_.data();
+}
+
+void SpanRasterizer::build(const int16_t *tops, const int16_t *bottoms,
+                           int winW, int winH) {
+  build(tops, bottoms, winW, winH, 0, 0, winW, winH);
+}
+
+void SpanRasterizer::build(const int16_t *tops, const int16_t *bottoms,
+                           int winW, int winH, int x0, int y0, int x1,
+                           int y1) {
+  winW_ = winW;
+  spans_.clear();
+  rowStart_.clear();
+  firstRow_ = endRow_ = lastEventRow_ = 0;
+  x0 = std::max(0, x0);
+  y0 = std::max(0, y0);
+  x1 = std::min(winW, x1);
+  y1 = std::min(winH, y1);
+  if (x0 >= x1 || y0 >= y1)
+    return;
+
+  // Counting sort of toggle events by row: a column switches on at its top
+  // and off again at its bottom (when that is inside the clip). Events only
+  // fall on rows [y0, y1), so the table covers just those: a band costs its
+  // own height, not the window's.
+  const int rows = y1 - y0;
+  eventStart_.assign(size_t(rows) + 2, 0u);
+  int firstEvent = y1, lastEvent = -1;
+  for (int x = x0; x < x1; ++x) {
+    int t = std::max<int>(y0, tops[x]);
+    int b = bottoms ? std::min<int>(y1, bottoms[x]) : y1;
+    if (t >= b)
+      continue;
+    ++eventStart_[size_t(t - y0) + 1];
+    firstEvent = std::min(firstEvent, t);
+    lastEvent = std::max(lastEvent, t);
+    if (b < y1) {
+      ++eventStart_[size_t(b - y0) + 1];
+      lastEvent = std::max(lastEvent, b);
+    }
+  }
+  if (lastEvent < 0)
+    return;
+  for (int r = 0; r <= rows; ++r)
+    eventStart_[size_t(r) + 1] += eventStart_[size_t(r)];
+  eventCols_.resize(eventStart_[size_t(rows)]);
+  {
+    // Scatter with eventStart_[r] as row r's cursor. That leaves every
+    // entry at the next row's start, so shift them back by one afterwards.
+    for (int x = x0; x < x1; ++x) {
+      int t = std::max<int>(y0, tops[x]);
+      int b = bottoms ? std::min<int>(y1, bottoms[x]) : y1;
+      if (t >= b)
+        continue;
+      eventCols_[eventStart_[size_t(t - y0)]++] = static_cast<int16_t>(x);
+      if (b < y1)
+        eventCols_[eventStart_[size_t(b - y0)]++] = static_cast<int16_t>(x);
+    }
+    for (int r = rows; r > 0; --r)
+      eventStart_[size_t(r)] = eventStart_[size_t(r) - 1];
+    eventStart_[0] = 0;
+  }
+
+  firstRow_ = firstEvent;
+  lastEventRow_ = lastEvent;
+  endRow_ = y1;
+  active_.assign((size_t(winW) + 63) / 64, 0ull);
+  rowStart_.reserve(size_t(lastEvent - firstEvent) + 2);
+  for (int y = firstEvent; y <= lastEvent; ++y) {
+    const size_t r = size_t(y - y0);
+    for (uint32_t i = eventStart_[r]; i < eventStart_[r + 1]; ++i) {
+      int x = eventCols_[i];
+      active_[size_t(x) >> 6] ^= 1ull << (x & 63);
+    }
+    rowStart_.push_back(uint32_t(spans_.size()));
+    emitRow();
+  }
+  rowStart_.push_back(uint32_t(spans_.size()));
+  // After the last event the active set no longer changes; if it is empty
+  // the region ends there.
+  if (rowStart_[rowStart_.size() - 1] == rowStart_[rowStart_.size() - 2])
+    endRow_ = lastEvent;
+}
+
+// Append the runs of set bits in active_ as spans.
+void SpanRasterizer::emitRow() {
+  int runStart = -1;
+  size_t words = active_.size();
+  for (size_t wi = 0; wi < words; ++wi) {
+    uint64_t w = active_[wi];
+    int base = int(wi * 64);
+    if (runStart >= 0) {
+      if (w == ~0ull)
+        continue;
+      int z = ctz64(~w);
+      spans_.push_back({static_cast<int16_t>(runStart),
+                        static_cast<int16_t>(base + z)});
+      runStart = -1;
+      w &= ~0ull << z;
+    }
+    while (w) {
+      int s = ctz64(w);
+      uint64_t zeros = ~w & (~0ull << s);
+      if (!zeros) {
+        runStart = base + s;
+        break;
+      }
+      int e = ctz64(zeros);
+      spans_.push_back(
+          {static_cast<int16_t>(base + s), static_cast<int16_t>(base + e)});
+      w &= ~0ull << e;
+    }
+  }
+  if (runStart >= 0)
+    spans_.push_back(
+        {static_cast<int16_t>(runStart), static_cast<int16_t>(winW_)});
+}
+
+const RowSpan *SpanRasterizer::rowBegin(int y) const {
+  size_t r = size_t(std::min(y, lastEventRow_) - firstRow_);
+  return spans_.data() + rowStart_[r];
+}
+
+const RowSpan *SpanRasterizer::rowEnd(int y) const {
+  size_t r = size_t(std::min(y, lastEventRow_) - firstRow_);
+  return spans_.data() + rowStart_[r + 1];
+}
+
+void SpanRasterizer::fill(uint32_t *pixels, int rowStride,
+                          uint32_t color) const {
+  fillRows(*this, pixels, rowStride, color);
+}
+
+void SpanRasterizer::fill(uint32_t *pixels, int rowStride,
+                          const uint32_t *rowColors) const {
+  fillRows(*this, pixels, rowStride, rowColors);
+}
+
+void SpanRasterizer::fill(uint16_t *pixels, int rowStride,
+                          uint16_t color) const {
+  fillRows(*this, pixels, rowStride, color);
+}
+
+void SpanRasterizer::fill(uint16_t *pixels, int rowStride,
+                          const uint16_t *rowColors) const {
+  fillRows(*this, pixels, rowStride, rowColors);
+}
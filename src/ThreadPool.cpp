@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace {
+thread_local bool t_insideTask = false;
+
+inline uint64_t packRange(uint32_t b, uint32_t e) {
+  return (uint64_t(b) << 32) | e;
+}
+} // namespace
+
+ThreadPool::ThreadPool(int workers) {
+  if (workers <= 0)
+    workers = int(std::max(1u, std::thread::hardware_concurrency())) - 1;
+  blocks_.reset(new Block[size_t(workers) + 1]);
+  threads_.reserve(size_t(workers));
+  for (int i = 0; i < workers; ++i)
+    threads_.emplace_back(&ThreadPool::workerLoop, this, i + 1);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+}
+
+bool ThreadPool::popFront(int slot, int &index) {
+  auto &r = blocks_[size_t(slot)].range;
+  uint64_t cur = r.load(std::memory_order_acquire);
+  for (;;) {
+    uint32_t b = uint32_t(cur >> 32), e = uint32_t(cur);
+    if (b >= e)
+      return false;
+    if (r.compare_exchange_weak(cur, packRange(b + 1, e),
+                                std::memory_order_acq_rel)) {
+      index = int(b);
+      return true;
+    }
+  }
+}
+
+bool ThreadPool::stealBack(int slot, int &index) {
+  auto &r = blocks_[size_t(slot)].range;
+  uint64_t cur = r.load(std::memory_order_acquire);
+  for (;;) {
+    uint32_t b = uint32_t(cur >> 32), e = uint32_t(cur);
+    if (b >= e)
+      return false;
+    if (r.compare_exchange_weak(cur, packRange(b, e - 1),
+                                std::memory_order_acq_rel)) {
+      index = int(e - 1);
+      return true;
+    }
+  }
+}
+
+// Run tasks from our own block, then steal until every block is empty.
+void ThreadPool::drain(int slot, const Task &task) {
+  const int slots = concurrency();
+  int index;
+  t_insideTask = true;
+  for (;;) {
+    bool got = popFront(slot, index);
+    for (int k = 1; !got && k < slots; ++k)
+      got = stealBack((slot + k) % slots, index);
+    if (!got)
+      break;
+    task(index);
+    remaining_.fetch_sub(1, std::memory_order_acq_rel);
+  }
+  t_insideTask = false;
+}
+
+void ThreadPool::workerLoop(int slot) {
+  uint64_t seen = 0;
+  for (;;) {
+    const Task *task;
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      wake_.wait(lk, [&] { return stop_ || generation_ != seen; });
+      if (stop_)
+        return;
+      seen = generation_;
+      // Woke up after the caller already finished this round.
+      if (!task_)
+        continue;
+      task = task_;
+      ++busyWorkers_;
+    }
+    drain(slot, *task);
+    {
+      std::lock_guard<std::mutex> lk(m_);
+      --busyWorkers_;
+    }
+    done_.notify_all();
+  }
+}
+
+void ThreadPool::run(int count, const Task &task) {
+  if (count <= 0)
+    return;
+  std::unique_lock<std::mutex> run(runMutex_, std::defer_lock);
+  if (t_insideTask || threads_.empty() || count == 1 || !run.try_lock()) {
+    for (int i = 0; i < count; ++i)
+      task(i);
+    return;
+  }
+
+  const int slots = concurrency();
+  for (int s = 0; s < slots; ++s) {
+    uint32_t b = uint32_t(int64_t(count) * s / slots);
+    uint32_t e = uint32_t(int64_t(count) * (s + 1) / slots);
+    blocks_[size_t(s)].range.store(packRange(b, e), std::memory_order_relaxed);
+  }
+  remaining_.store(count, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lk(m_);
+    task_ = &task;
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  drain(0, task);
+
+  // Wait for the last tasks and for every worker to leave drain(); clearing
+  // task_ under the lock keeps late wakers out, so nobody touches 'task' or
+  // the blocks once we return.
+  std::unique_lock<std::mutex> lk(m_);
+  done_.wait(lk, [&] {
+    return remaining_.load(std::memory_order_acquire) == 0 &&
+           busyWorkers_ == 0;
+  });
+  task_ = nullptr;
+}
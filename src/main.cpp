@@ -1,117 +1,331 @@
 
-#include "SDLRenderer.h"
+#include "AsyncSceneBuilder.h"
+#include "BatchRender.h"
+#include "FramePacer.h"
+#include "HeadlessRenderer.h"
+#include "HeightfieldLayer.h"
+#include "Profiler.h"
 #include "Scene.h"
+#include "ScenePresets.h"
+#include "ScrollingMountainLayer.h"
+#ifdef MOUNTAINS_HAVE_SDL
+#include "SDLRenderer.h"
+#endif
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <memory>
 #include <random>
+#include <string>
 #include <vector>
 
-static inline MountainColorScheme getNordScheme() {
-  MountainColorScheme s;
-  s.skyTop = 0xFF2E3440u;
-  s.skyBottom = 0xFFD8DEE9u;
-  s.fogColor = lerpColor(s.skyBottom, 0xFF88C0D0u, 0.07);
-  s.sunColor = 0xFF8FBCBBu;
-  return s;
+// A fresh scene seed for interactive regeneration.
+static uint64_t randomSceneSeed() {
+  std::random_device rd;
+  return (uint64_t(rd()) << 32) | rd();
 }
 
-static inline MountainColorScheme getEverforestScheme() {
-  MountainColorScheme s;
-  s.skyTop = 0xFF1E2326u;
-  s.skyBottom = 0xFFE67E80u;
-  s.fogColor = 0x00D8DEE9u;
-  s.sunColor = 0xFFF6E9B3u;
-  return s;
-}
+enum class SceneStyle : uint8_t {
+  Ridges,    // independent ridges
+  Scrolling, // every ridge on its own endless parallax layer
+  Terrain,   // ridges cut from one diamond-square heightfield
+};
 
-static const std::vector<uint32_t> NORD_PALETTE = {
-    0xFF2E3440u, 0xFF3B4252u, 0xFF434C5Eu, 0xFF4C566Au,
-    0xFFD8DEE9u, 0xFF8FBCBBu, 0xFF88C0D0u, 0xFF81A1C1u};
-static const std::vector<uint32_t> EVER_PALETTE = {
-    0xFF1B3B2Bu, 0xFF2A5B3Au, 0xFF3B7B49u, 0xFF4C9B58u, 0xFF6BBA6Bu};
-
-std::vector<MountainParams>
-makeRandomMountainsWithPalette(size_t count, int winW,
-                               const std::vector<uint32_t> &palette,
-                               const MountainColorScheme &scheme) {
-  std::vector<MountainParams> out;
-  out.reserve(count);
-  static thread_local std::mt19937 rng((uint32_t)std::random_device{}());
-  std::uniform_real_distribution<double> uf01(0.0, 1.0);
-  for (size_t i = 0; i < count; ++i) {
-    double t = double(i) / double(std::max<size_t>(1, count - 1));
-    MountainParams p;
-    p.width = winW;
-    p.seed = static_cast<uint32_t>(rng() ^ (uint32_t)(i * 2654435761u));
-    p.leftHeight = 0.05 + 0.15 * uf01(rng) + 0.06 * t;
-    p.rightHeight = 0.05 + 0.15 * uf01(rng) + 0.06 * t;
-    p.initialDisplacement = 0.5 + 0.9 * uf01(rng) + 0.4 * t;
-    p.roughness = 0.48;
-    p.minHeight = 0;
-    p.maxHeight = 1.5 - t;
-    p.verticalSpan = 0.5 + 0.45 * t;
-    p.verticalOffset = static_cast<int>(30.0 * (1.0 + t));
-
-    uint32_t baseColor;
-    if (!palette.empty()) {
-      size_t idx = std::min<size_t>(i, palette.size() - 1);
-      baseColor = palette[idx];
-    } else {
-      uint8_t g = uint8_t(30 + (rng() % 140));
-      baseColor = packARGB(0xFF, g, g, g);
+// Background job for AsyncSceneBuilder: a fresh random scene, abandoned as
+// soon as a newer request comes in. With SceneStyle::Scrolling nearer
+// ridges move faster. Ridges and terrain generate on 'pool', which must not
+// be the frame loop's (a busy pool runs other callers serially), and ridges
+// into the previous scene's buffers.
+static AsyncSceneBuilder::Job
+makeSceneJob(int winW, int winH, size_t count, std::vector<uint32_t> palette,
+             MountainColorScheme scheme, SceneStyle style, uint64_t sceneSeed,
+             std::shared_ptr<ThreadPool> pool) {
+  return [=](Scene *retired, const AsyncSceneBuilder::CancelCheck &cancelled) {
+    auto scene = std::make_unique<Scene>(winW, winH, scheme);
+    if (style == SceneStyle::Terrain) {
+      auto terrain = std::make_shared<Heightfield>();
+      terrain->generate(makeRandomTerrain(winW, sceneSeed), pool.get());
+      if (cancelled())
+        return std::unique_ptr<Scene>();
+      scene->addLayer(std::make_unique<HeightfieldLayer>(
+          std::move(terrain), makeTerrainSlices(count, palette, scheme),
+          pool.get()));
+      return scene;
     }
+    auto params = makeRandomMountainsWithPalette(count, winW, palette, scheme,
+                                                 sceneSeed);
+    if (style == SceneStyle::Ridges) {
+      // Only ridge scenes use the spares; others would just hold them.
+      if (retired)
+        scene->recycle(std::move(*retired));
+      scene->setThreadPool(pool);
+      if (!scene->buildMountains(std::move(params), 0,
+                                 [&](size_t, size_t) { return !cancelled(); }))
+        return std::unique_ptr<Scene>();
+      return scene;
+    }
+    for (size_t i = 0; i < params.size(); ++i) {
+      if (cancelled())
+        return std::unique_ptr<Scene>();
+      double t = double(i) / double(std::max<size_t>(1, count - 1));
+      scene->addLayer(std::make_unique<ScrollingMountainLayer>(
+          std::vector<MountainParams>{std::move(params[i])}, 8.0 + 52.0 * t,
+          winW, winH));
+    }
+    return scene;
+  };
+}
 
-    double fogStrength = 0 * (1.0 - t); // tweak multiplier to taste
-    p.colorARGB = lerpColor(baseColor, scheme.fogColor, fogStrength);
+struct AppOptions {
+  int width = 1024;
+  int height = 512;
+  bool headless = false;
+  uint64_t frames = 0;  // headless: stop after this many frames
+  std::string keys;     // headless: scripted key presses, one per frame
+  std::string dumpPath; // headless: write the last frame here (.ppm/.png/raw)
+  int resizeW = 0, resizeH = 0; // headless: resize after the key script
+  int threads = 0;      // render threads (0 = all cores, 1 = no pool)
+  double fps = -1.0;    // frame rate cap (0 = uncapped, < 0 = default)
+  std::string profilePath; // profiling builds: periodic summaries (.json/.csv)
+  uint64_t seed = 0;       // first scene's seed (0 = random)
+  bool antiAlias = false;  // start with anti-aliased ridge edges
+  double morph = 0.0;      // start morphing, seconds per morph (0 = off)
+  bool batch = false;      // render a seed range to files and exit
+  bool sizeSet = false;    // --size given (else a loaded scene's size)
+  std::string loadPath;    // first scene from this scene file
+  std::string savePath;    // save the last scene here on exit
+  bool saveSamples = true; // store height pyramids in the saved file
+  bool pixelFormatSet = false; // else the renderer picks the format
+  PixelFormat pixelFormat = PixelFormat::ARGB8888;
+  BatchOptions batchOpts;  // size and threads are copied in parseArgs()
+};
 
-    out.push_back(std::move(p));
-  }
-  return out;
+static void printUsage(const char *argv0) {
+  std::fprintf(stderr,
+               "usage: %s [--size WxH] [--threads N] [--fps N] [--seed N] [--aa]\n"
+               "          [--morph S] [--headless] [--frames N] [--keys KEYS]\n"
+               "          [--resize WxH] [--dump FILE] [--profile FILE]\n"
+               "          [--load FILE] [--save FILE] [--save-params-only]\n"
+               "          [--pixel-format argb8888|xrgb8888|rgb565]\n"
+               "       %s --batch A-B [--out DIR] [--format png|ppm]\n"
+               "          [--palette nord|everforest|random] [--mountains N]\n"
+               "          [--size WxH] [--threads N] [--aa]\n"
+               "  --threads N  render threads (0 = all cores, default)\n"
+               "  --fps N      frame rate cap, 0 = uncapped (default 120,\n"
+               "               headless uncapped)\n"
+               "  --seed N     seed of the first scene (default random)\n"
+               "  --aa         anti-aliased ridge edges (toggle with A)\n"
+               "  --morph S    keep morphing the ridges into new seeds, S\n"
+               "               seconds each (toggle with M, default 8)\n"
+               "  --headless   render offscreen (implied without SDL)\n"
+               "  --frames N   headless: stop after N frames (default 600)\n"
+               "  --keys KEYS  headless: one key per frame, e.g. \" 5e\"\n"
+               "  --resize WxH headless: resize the output after the keys\n"
+               "  --dump FILE  headless: save the last frame (.ppm, .png, raw)\n"
+               "  --profile FILE  append frame time summaries every %d frames\n"
+               "               (.json, else CSV; needs -DMOUNTAINS_PROFILE=ON)\n"
+               "  --load FILE  start with a saved scene (and its size)\n"
+               "  --save FILE  save the scene on exit; --save-params-only\n"
+               "               stores no heights, so loading regenerates\n"
+               "  --pixel-format F  texture format (default: the backend's\n"
+               "               choice; headless argb8888)\n"
+               "  --batch A-B  render scene seeds A..B to DIR/mountains_<seed>\n"
+               "               without a window and print images/s; --threads\n"
+               "               sets the workers per pipeline stage\n"
+               "  --out DIR    batch output directory (default .)\n"
+               "  --format F   batch image format (default png)\n"
+               "  --palette P  batch palette (default nord)\n"
+               "  --mountains N  batch ridges per scene (default 3)\n",
+               argv0, argv0, Profiler::kHistory);
 }
 
-std::vector<MountainParams>
-makeRandomMountainsNord(size_t count, int winW,
-                        const MountainColorScheme &scheme) {
-  return makeRandomMountainsWithPalette(count, winW, NORD_PALETTE, scheme);
-}
-std::vector<MountainParams>
-makeRandomMountainsEverforest(size_t count, int winW,
-                              const MountainColorScheme &scheme) {
-  return makeRandomMountainsWithPalette(count, winW, EVER_PALETTE, scheme);
+static bool parseArgs(int argc, char **argv, AppOptions &opts) {
+  for (int i = 1; i < argc; ++i) {
+    const char *a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (std::strcmp(a, "--headless") == 0) {
+      opts.headless = true;
+    } else if (std::strcmp(a, "--aa") == 0) {
+      opts.antiAlias = true;
+    } else if (std::strcmp(a, "--morph") == 0 && hasValue) {
+      opts.morph = std::atof(argv[++i]);
+      if (opts.morph <= 0.0)
+        return false;
+    } else if (std::strcmp(a, "--size") == 0 && hasValue) {
+      if (std::sscanf(argv[++i], "%dx%d", &opts.width, &opts.height) != 2 ||
+          opts.width < 2 || opts.height < 2)
+        return false;
+      opts.sizeSet = true;
+    } else if (std::strcmp(a, "--threads") == 0 && hasValue) {
+      opts.threads = std::atoi(argv[++i]);
+      if (opts.threads < 0)
+        return false;
+    } else if (std::strcmp(a, "--fps") == 0 && hasValue) {
+      opts.fps = std::atof(argv[++i]);
+      if (opts.fps < 0.0)
+        return false;
+    } else if (std::strcmp(a, "--seed") == 0 && hasValue) {
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(a, "--batch") == 0 && hasValue) {
+      unsigned long long first = 0, last = 0;
+      if (std::sscanf(argv[++i], "%llu-%llu", &first, &last) != 2 ||
+          last < first)
+        return false;
+      opts.batch = true;
+      opts.batchOpts.firstSeed = first;
+      opts.batchOpts.lastSeed = last;
+    } else if (std::strcmp(a, "--out") == 0 && hasValue) {
+      opts.batchOpts.outDir = argv[++i];
+    } else if (std::strcmp(a, "--format") == 0 && hasValue) {
+      opts.batchOpts.format = argv[++i];
+      if (opts.batchOpts.format != "png" && opts.batchOpts.format != "ppm")
+        return false;
+    } else if (std::strcmp(a, "--palette") == 0 && hasValue) {
+      const char *p = argv[++i];
+      if (std::strcmp(p, "nord") == 0)
+        opts.batchOpts.palette = BatchPalette::Nord;
+      else if (std::strcmp(p, "everforest") == 0)
+        opts.batchOpts.palette = BatchPalette::Everforest;
+      else if (std::strcmp(p, "random") == 0)
+        opts.batchOpts.palette = BatchPalette::Random;
+      else
+        return false;
+    } else if (std::strcmp(a, "--mountains") == 0 && hasValue) {
+      int n = std::atoi(argv[++i]);
+      if (n < 1)
+        return false;
+      opts.batchOpts.mountains = size_t(n);
+    } else if (std::strcmp(a, "--frames") == 0 && hasValue) {
+      opts.frames = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(a, "--keys") == 0 && hasValue) {
+      opts.keys = argv[++i];
+    } else if (std::strcmp(a, "--resize") == 0 && hasValue) {
+      if (std::sscanf(argv[++i], "%dx%d", &opts.resizeW, &opts.resizeH) != 2 ||
+          opts.resizeW < 2 || opts.resizeH < 2)
+        return false;
+    } else if (std::strcmp(a, "--load") == 0 && hasValue) {
+      opts.loadPath = argv[++i];
+    } else if (std::strcmp(a, "--save") == 0 && hasValue) {
+      opts.savePath = argv[++i];
+    } else if (std::strcmp(a, "--save-params-only") == 0) {
+      opts.saveSamples = false;
+    } else if (std::strcmp(a, "--pixel-format") == 0 && hasValue) {
+      const char *f = argv[++i];
+      opts.pixelFormatSet = true;
+      if (std::strcmp(f, "argb8888") == 0)
+        opts.pixelFormat = PixelFormat::ARGB8888;
+      else if (std::strcmp(f, "xrgb8888") == 0)
+        opts.pixelFormat = PixelFormat::XRGB8888;
+      else if (std::strcmp(f, "rgb565") == 0)
+        opts.pixelFormat = PixelFormat::RGB565;
+      else
+        return false;
+    } else if (std::strcmp(a, "--dump") == 0 && hasValue) {
+      opts.dumpPath = argv[++i];
+    } else if (std::strcmp(a, "--profile") == 0 && hasValue) {
+      opts.profilePath = argv[++i];
+      if (!Profiler::kEnabled) {
+        std::fprintf(stderr, "--profile: built without MOUNTAINS_PROFILE\n");
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  opts.batchOpts.width = opts.width;
+  opts.batchOpts.height = opts.height;
+  opts.batchOpts.threads = opts.threads;
+  opts.batchOpts.antiAlias = opts.antiAlias;
+#ifndef MOUNTAINS_HAVE_SDL
+  opts.headless = true;
+#endif
+  if (opts.headless && opts.frames == 0)
+    opts.frames = 600;
+  if (opts.fps < 0.0)
+    opts.fps = opts.headless ? 0.0 : 120.0;
+  return true;
 }
 
-int main() {
-  const int WIN_W = 1024;
-  const int WIN_H = 512;
-
-  SDLRenderer renderer;
-  if (!renderer.init(WIN_W, WIN_H, "Mountains"))
-    return 1;
-
+// The platform-independent frame loop. Returns the number of frames rendered.
+// 'loaded', if set, is the first scene; otherwise one is generated.
+static uint64_t runFrameLoop(IRenderer &renderer, const AppOptions &opts,
+                             std::unique_ptr<Scene> loaded) {
+  int winW = opts.width;
+  int winH = opts.height;
+  std::shared_ptr<ThreadPool> pool;
+  // Background builds get their own, smaller pool, so frames keep every
+  // render thread while a scene generates.
+  std::shared_ptr<ThreadPool> buildPool;
+  if (opts.threads != 1) {
+    pool = std::make_shared<ThreadPool>(opts.threads - 1);
+    buildPool = std::make_shared<ThreadPool>(
+        std::max(1, (pool->concurrency() - 1) / 2));
+  }
   MountainColorScheme currentScheme = getNordScheme();
   std::vector<uint32_t> currentPalette = NORD_PALETTE;
   size_t currentCount = 3;
-  Scene scene =
-      Scene::makeDefault(WIN_W, WIN_H, static_cast<int>(currentCount));
+  SceneStyle style = SceneStyle::Ridges;
+  CompositeMode composite = CompositeMode::FrontToBack;
+  bool antiAlias = opts.antiAlias;
+  const double morphSeconds = opts.morph > 0.0 ? opts.morph : 8.0;
+  bool morphing = opts.morph > 0.0;
 
-  Scene newScene(WIN_W, WIN_H, currentScheme);
-  auto params = makeRandomMountainsWithPalette(currentCount, WIN_W,
-                                               currentPalette, currentScheme);
-  for (auto &p : params)
-    newScene.addMountain(std::move(p));
-  scene = std::move(newScene);
+  // The first scene is built up front; later ones come from the builder and
+  // are swapped in at the top of a frame, so regeneration never stalls one.
+  std::unique_ptr<Scene> scene = std::move(loaded);
+  if (scene) {
+    currentScheme = scene->scheme();
+    currentCount = scene->getMountains().size();
+    scene->resize(winW, winH);
+  } else {
+    scene = std::make_unique<Scene>(winW, winH, currentScheme);
+    scene->setMountains(makeRandomMountainsWithPalette(
+        currentCount, winW, currentPalette, currentScheme,
+        opts.seed ? opts.seed : randomSceneSeed()));
+  }
+  scene->setThreadPool(pool);
+  AsyncSceneBuilder builder;
 
-  std::vector<uint32_t> buffer(WIN_W * WIN_H);
-  const int rowStride = WIN_W;
+  // Only used when the renderer cannot hand out a pixel-aligned frame; whole
+  // words of any pixel format.
+  std::vector<uint32_t> buffer;
 
   bool running = true;
+  uint64_t frames = 0;
   std::vector<Event> events;
-  auto last = std::chrono::steady_clock::now();
+  FramePacer pacer(opts.fps);
+  pacer.setIdleSleep(!opts.headless);
+
+  bool showOverlay = false;
+  std::FILE *profileOut = nullptr;
+  bool profileJson = false;
+  if (Profiler::kEnabled && !opts.profilePath.empty()) {
+    profileOut = std::fopen(opts.profilePath.c_str(), "w");
+    if (!profileOut)
+      std::fprintf(stderr, "failed to open %s\n", opts.profilePath.c_str());
+    const std::string &p = opts.profilePath;
+    profileJson = p.size() >= 5 && p.compare(p.size() - 5, 5, ".json") == 0;
+  }
+  auto dumpProfile = [&](bool header) {
+    if (!profileOut)
+      return;
+    if (profileJson)
+      Profiler::instance().writeJson(profileOut);
+    else
+      Profiler::instance().writeCsv(profileOut, header);
+  };
+
+  // Left-button drags sculpt the ridge the press landed on. Pointer moves
+  // are coalesced to one edit per frame.
+  int sculptRidge = -1;
 
   while (running) {
+    double dt = pacer.beginFrame();
 
     running = renderer.pollEvents(events);
 
@@ -119,26 +333,63 @@ int main() {
     bool switchPaletteNord = false;
     bool switchPaletteEver = false;
     bool switchPaletteRandom = false;
+    bool toggleComposite = false;
+    bool toggleScrolling = false;
+    bool toggleTerrain = false;
+    bool toggleAntiAlias = false;
+    bool toggleMorph = false;
     int numericKeyPressed = -1; // -1 none, otherwise 1..10
+    int sculptX = -1, sculptY = -1;
+    bool sculptReleased = false;
+    bool exposed = false; // the window needs the last frame shown again
 
     for (const auto &e : events) {
       if (e.type == Event::Type::Quit) {
         running = false;
         break;
       }
+      if (e.type == Event::Type::Resize) {
+        winW = e.x;
+        winH = e.y;
+        scene->resize(winW, winH);
+      }
+      if (e.type == Event::Type::Expose)
+        exposed = true;
+      if (e.type == Event::Type::MouseDown && e.code == MouseButton::Left)
+        sculptRidge = scene->mountainAt(e.x, e.y);
+      if ((e.type == Event::Type::MouseDown ||
+           e.type == Event::Type::MouseMove) &&
+          sculptRidge >= 0) {
+        sculptX = e.x;
+        sculptY = e.y;
+      }
+      if (e.type == Event::Type::MouseUp && e.code == MouseButton::Left)
+        sculptReleased = true;
       if (e.type == Event::Type::KeyDown) {
         int kc = e.code;
-        if (kc == SDLK_SPACE)
+        if (kc == Key::Space)
           regenRequested = true;
-        else if (kc == SDLK_n)
+        else if (kc == Key::N)
           switchPaletteNord = true;
-        else if (kc == SDLK_e)
+        else if (kc == Key::E)
           switchPaletteEver = true;
-        else if (kc == SDLK_r)
+        else if (kc == Key::R)
           switchPaletteRandom = true;
-        else if (kc >= SDLK_0 && kc <= SDLK_9) {
-          numericKeyPressed = (kc == SDLK_0) ? 10 : (kc - SDLK_0);
-        } else if (kc == SDLK_q || kc == SDLK_ESCAPE) {
+        else if (kc == Key::C)
+          toggleComposite = true;
+        else if (kc == Key::S)
+          toggleScrolling = true;
+        else if (kc == Key::T)
+          toggleTerrain = true;
+        else if (kc == Key::A)
+          toggleAntiAlias = true;
+        else if (kc == Key::M)
+          toggleMorph = true;
+        else if (kc == Key::P && Profiler::kEnabled)
+          showOverlay = !showOverlay;
+        else if (kc >= Key::Num0 && kc <= Key::Num9) {
+          numericKeyPressed = (kc == Key::Num0) ? 10 : (kc - Key::Num0);
+        } else if (kc == Key::Q || kc == Key::Escape) {
           running = false;
           break;
         }
@@ -148,53 +399,200 @@ int main() {
     if (!running)
       break;
 
+    if (sculptRidge >= 0 && sculptX >= 0)
+      scene->sculpt(sculptRidge, sculptX, sculptY, std::max(8, winW / 16));
+    if (sculptReleased)
+      sculptRidge = -1;
+
     if (switchPaletteNord) {
       currentScheme = getNordScheme();
       currentPalette = NORD_PALETTE;
-      scene.setScheme(currentScheme);
+      scene->setScheme(currentScheme);
     } else if (switchPaletteEver) {
       currentScheme = getEverforestScheme();
       currentPalette = EVER_PALETTE;
-      scene.setScheme(currentScheme);
+      scene->setScheme(currentScheme);
     } else if (switchPaletteRandom) {
       currentPalette.clear();
       currentScheme = {};
-      scene.setScheme(currentScheme);
+      scene->setScheme(currentScheme);
     }
 
-    if (numericKeyPressed > 0) {
-      size_t n = static_cast<size_t>(numericKeyPressed);
-
-      Scene newScene(WIN_W, WIN_H, currentScheme);
-      auto params = makeRandomMountainsWithPalette(n, WIN_W, currentPalette,
-                                                   currentScheme);
-      for (auto &p : params)
-        newScene.addMountain(std::move(p));
-      scene = std::move(newScene);
-      currentCount = n;
-    } else if (regenRequested) {
-
-      Scene newScene(WIN_W, WIN_H, currentScheme);
-      auto params = makeRandomMountainsWithPalette(
-          currentCount, WIN_W, currentPalette, currentScheme);
-      for (auto &p : params)
-        newScene.addMountain(std::move(p));
-      scene = std::move(newScene);
+    if (toggleComposite)
+      composite = composite == CompositeMode::Painter
+                      ? CompositeMode::FrontToBack
+                      : CompositeMode::Painter;
+
+    if (toggleAntiAlias)
+      antiAlias = !antiAlias;
+
+    if (toggleMorph)
+      morphing = !morphing;
+
+    if (toggleScrolling || toggleTerrain) {
+      SceneStyle toggled =
+          toggleTerrain ? SceneStyle::Terrain : SceneStyle::Scrolling;
+      style = style == toggled ? SceneStyle::Ridges : toggled;
+      regenRequested = true;
+    }
+    if (numericKeyPressed > 0)
+      currentCount = static_cast<size_t>(numericKeyPressed);
+    if (numericKeyPressed > 0 || regenRequested)
+      builder.submit(makeSceneJob(winW, winH, currentCount, currentPalette,
+                                  currentScheme, style, randomSceneSeed(),
+                                  buildPool));
+
+    if (auto next = builder.takeReady()) {
+      // The palette or the window may have changed while it was being built.
+      next->setScheme(currentScheme);
+      next->resize(winW, winH);
+      builder.retire(std::move(scene));
+      scene = std::move(next);
+      sculptRidge = -1;
+    }
+
+    scene->setCompositeMode(composite);
+    scene->setRasterMode(RasterMode::Spans);
+    scene->setAntiAliasing(antiAlias);
+    scene->setMorphing(morphing ? morphSeconds : 0.0);
+    scene->setThreadPool(pool);
+    // The overlay changes every frame; with the frame cache, the scene under
+    // it is a copy rather than a re-render.
+    scene->setFrameCacheEnabled(showOverlay);
+    scene->update(dt);
+    // The texture keeps the last frame, so an unchanged scene costs neither
+    // render work nor an upload, and the window keeps showing it without
+    // another present().
+    const bool rendered = scene->isDirty() || showOverlay;
+    if (rendered) {
+      FrameBuffer fb = renderer.beginFrame();
+      const PixelFormat format = renderer.pixelFormat();
+      const int pixelBytes = pixel_format_bytes(format);
+      const size_t rowBytes = size_t(winW) * size_t(pixelBytes);
+      const bool direct = fb.pixels && fb.pitch % pixelBytes == 0;
+      void *target = fb.pixels;
+      int stride = fb.pitch / pixelBytes;
+      if (!direct) {
+        buffer.resize((rowBytes * size_t(winH) + 3) / 4);
+        target = buffer.data();
+        stride = winW;
+      }
+      scene->render(target, stride, format);
+      if (showOverlay)
+        Profiler::instance().drawOverlay(target, stride, winW, winH, format);
+      if (direct) {
+        renderer.endFrame();
+      } else if (fb.pixels) {
+        // Pitch is not a whole number of pixels: copy row by row.
+        auto *dst = static_cast<uint8_t *>(fb.pixels);
+        auto *src = reinterpret_cast<const uint8_t *>(buffer.data());
+        for (int y = 0; y < winH; ++y)
+          std::memcpy(dst + size_t(y) * size_t(fb.pitch),
+                      src + size_t(y) * rowBytes, rowBytes);
+        renderer.endFrame();
+      } else {
+        renderer.updateTexture(buffer.data(), int(rowBytes));
+      }
+    }
+    const bool presented = rendered || exposed;
+    if (presented)
+      renderer.present();
+    ++frames;
+
+    // Waits only for what is left of the frame budget; with vsync, present()
+    // usually used it up already. Frames with nothing new just sleep.
+    pacer.endFrame(presented);
+    if (Profiler::kEnabled) {
+      Profiler::instance().endFrame(uint64_t(pacer.lastFrameSeconds() * 1e9));
+      if (frames % Profiler::kHistory == 0)
+        dumpProfile(frames == Profiler::kHistory);
+    }
+  }
+  if (profileOut) {
+    if (frames % Profiler::kHistory != 0)
+      dumpProfile(frames < Profiler::kHistory);
+    std::fclose(profileOut);
+  }
+  std::string error;
+  if (!opts.savePath.empty() &&
+      !scene->save(opts.savePath, opts.saveSamples, &error))
+    std::fprintf(stderr, "%s\n", error.c_str());
+  return frames;
+}
+
+int main(int argc, char **argv) {
+  AppOptions opts;
+  if (!parseArgs(argc, argv, opts)) {
+    printUsage(argv[0]);
+    return 2;
+  }
+
+  // Loaded before the window opens, so the window can take the scene's size.
+  std::unique_ptr<Scene> loaded;
+  if (!opts.loadPath.empty() && !opts.batch) {
+    std::string error;
+    loaded = Scene::load(opts.loadPath, nullptr, &error);
+    if (!loaded) {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    if (!opts.sizeSet) {
+      opts.width = loaded->width();
+      opts.height = loaded->height();
     }
+  }
+  const int WIN_W = opts.width;
+  const int WIN_H = opts.height;
 
-    auto now = std::chrono::steady_clock::now();
-    std::chrono::duration<double> dt = now - last;
-    last = now;
+  if (opts.batch) {
+    BatchStats stats = render_batch(opts.batchOpts);
+    std::printf("%llu images in %.3f s (%.1f images/s)\n",
+                static_cast<unsigned long long>(stats.images), stats.seconds,
+                stats.imagesPerSecond());
+    if (stats.failed > 0) {
+      std::fprintf(stderr, "failed to write %llu images, first %s\n",
+                   static_cast<unsigned long long>(stats.failed),
+                   stats.firstFailure.c_str());
+      return 1;
+    }
+    return 0;
+  }
 
-    scene.update(dt.count());
-    scene.render(buffer.data(), rowStride);
+  if (opts.headless) {
+    HeadlessRenderer renderer;
+    if (opts.pixelFormatSet)
+      renderer.requestPixelFormat(opts.pixelFormat);
+    if (!renderer.init(WIN_W, WIN_H, "Mountains"))
+      return 1;
+    renderer.setFrameLimit(opts.frames);
+    for (char c : opts.keys)
+      renderer.scriptKey(static_cast<unsigned char>(c));
+    if (opts.resizeW > 0)
+      renderer.scriptResize(opts.resizeW, opts.resizeH);
 
-    renderer.updateTexture(buffer.data(), rowStride * 4);
-    renderer.present();
+    auto t0 = std::chrono::steady_clock::now();
+    uint64_t frames = runFrameLoop(renderer, opts, std::move(loaded));
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - t0;
+    std::printf("%llu frames in %.3f s (%.1f fps)\n",
+                static_cast<unsigned long long>(frames), secs.count(),
+                secs.count() > 0.0 ? double(frames) / secs.count() : 0.0);
 
-    SDL_Delay(8);
+    if (!opts.dumpPath.empty() && !renderer.saveFrame(opts.dumpPath)) {
+      std::fprintf(stderr, "failed to write %s\n", opts.dumpPath.c_str());
+      return 1;
+    }
+    renderer.cleanup();
+    return 0;
   }
 
+#ifdef MOUNTAINS_HAVE_SDL
+  SDLRenderer renderer;
+  if (opts.pixelFormatSet)
+    renderer.requestPixelFormat(opts.pixelFormat);
+  if (!renderer.init(WIN_W, WIN_H, "Mountains"))
+    return 1;
+  runFrameLoop(renderer, opts, std::move(loaded));
   renderer.cleanup();
+#endif
   return 0;
 }
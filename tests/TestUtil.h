@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the CTest executables: a failed CHECK prints where and
+// why and makes the test return nonzero, but the remaining checks still run.
+inline int &test_failures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(cond)                                                           \
+  do {                                                                        \
+    if (!(cond)) {                                                            \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+                   #cond);                                                    \
+      ++test_failures();                                                      \
+    }                                                                         \
+  } while (0)
+
+// CHECK(a op b) that also prints both sides as unsigned long long.
+#define CHECK_OP(a, op, b)                                                    \
+  do {                                                                        \
+    auto va_ = (a);                                                           \
+    auto vb_ = (b);                                                           \
+    if (!(va_ op vb_)) {                                                      \
+      std::fprintf(stderr, "%s:%d: CHECK(%s %s %s) failed: %llu vs %llu\n",   \
+                   __FILE__, __LINE__, #a, #op, #b,                           \
+                   static_cast<unsigned long long>(va_),                      \
+                   static_cast<unsigned long long>(vb_));                     \
+      ++test_failures();                                                      \
+    }                                                                         \
+  } while (0)
+
+inline int test_result(const char *name) {
+  if (test_failures() == 0)
+    std::printf("%s: ok\n", name);
+  return test_failures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+// Steady-state frames allocate nothing, and rebuilding a scene into a
+// recycled one allocates a bounded amount (AllocationCounter.h).
+#include "AllocationCounter.h"
+#include "Scene.h"
+#include "ScenePresets.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kWidth = 640, kHeight = 360;
+constexpr size_t kRidges = 6;
+constexpr int kFrames = 8;
+
+std::vector<MountainParams> ridges(uint64_t sceneSeed) {
+  return makeRandomMountainsWithPalette(kRidges, kWidth, NORD_PALETTE,
+                                        getNordScheme(), sceneSeed);
+}
+
+// Every composite and raster mode, with and without the pool, after one
+// warm-up frame that sizes the caches.
+void steadyStateFrames() {
+  Scene scene(kWidth, kHeight, getNordScheme());
+  scene.setMountains(ridges(1));
+  auto pool = std::make_shared<ThreadPool>(3);
+  std::vector<uint32_t> fb(size_t(kWidth) * kHeight);
+  for (bool threaded : {false, true})
+    for (CompositeMode composite :
+         {CompositeMode::Painter, CompositeMode::FrontToBack})
+      for (RasterMode raster : {RasterMode::Columns, RasterMode::Spans})
+        for (bool antiAlias : {false, true}) {
+          scene.setThreadPool(threaded ? pool : nullptr);
+          scene.setCompositeMode(composite);
+          scene.setRasterMode(raster);
+          scene.setAntiAliasing(antiAlias);
+          scene.markDirty();
+          scene.render(fb.data(), kWidth);
+          AllocationScope frames;
+          for (int f = 0; f < kFrames; ++f) {
+            scene.update(1.0 / 60.0);
+            scene.markDirty();
+            scene.render(fb.data(), kWidth);
+          }
+          CHECK_OP(frames.count(), ==, 0u);
+        }
+}
+
+// Frames across many morph boundaries, with and without the pool. The next
+// targets generate on the BackgroundWorker, which allocates their ridge
+// generators; the frame thread hands them over and reuses the last morph's
+// targets, so once two sets exist it allocates nothing. The short sleep per
+// frame keeps the worker ahead of the morphs.
+void morphingFrames() {
+  constexpr int kMorphFrames = 6, kMorphs = 8;
+  Scene scene(kWidth, kHeight, getNordScheme());
+  scene.setMountains(ridges(1));
+  scene.setMorphing(kMorphFrames / 60.0);
+  auto pool = std::make_shared<ThreadPool>(3);
+  std::vector<uint32_t> fb(size_t(kWidth) * kHeight);
+  std::vector<uint32_t> before(fb.size());
+  auto frame = [&] {
+    scene.update(1.0 / 60.0);
+    scene.render(fb.data(), kWidth);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  };
+  for (bool threaded : {false, true}) {
+    scene.setThreadPool(threaded ? pool : nullptr);
+    for (int f = 0; f < 3 * kMorphFrames; ++f)
+      frame();
+    before = fb;
+    ThreadAllocationScope frames;
+    for (int f = 0; f < kMorphs * kMorphFrames; ++f)
+      frame();
+    CHECK_OP(frames.count(), ==, 0u);
+    CHECK(fb != before);
+  }
+}
+
+// A rebuild into a recycled scene of the same size and ridge count only
+// allocates the ridge generators and the mountain list's bookkeeping.
+void recycledRebuild() {
+  std::vector<uint32_t> fb(size_t(kWidth) * kHeight);
+  auto scene = std::make_unique<Scene>(kWidth, kHeight, getNordScheme());
+  scene->setMountains(ridges(1));
+  scene->render(fb.data(), kWidth);
+  for (uint64_t seed = 2; seed < 6; ++seed) {
+    auto params = ridges(seed);
+    auto next = std::make_unique<Scene>(kWidth, kHeight, getNordScheme());
+    next->recycle(std::move(*scene));
+    AllocationScope rebuild;
+    CHECK(next->buildMountains(std::move(params)));
+    next->render(fb.data(), kWidth);
+    CHECK_OP(rebuild.count(), <=, 2 * kRidges);
+    scene = std::move(next);
+  }
+}
+
+} // namespace
+
+int main() {
+  steadyStateFrames();
+  morphingFrames();
+  recycledRebuild();
+  return test_result("allocation_test");
+}
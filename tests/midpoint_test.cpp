@@ -0,0 +1,45 @@
+// Hashed midpoint displacement gives the same bits serially, on pools of any
+// size, and when called from inside a pool task (MidpointDisplacement.h).
+#include "MidpointDisplacement.h"
+#include "ThreadPool.h"
+#include "TestUtil.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int kSamples = (1 << 17) + 1;
+
+std::vector<double> displace(ThreadPool *pool) {
+  std::vector<double> h(size_t(kSamples), 0.0);
+  h.front() = 0.25;
+  h.back() = 0.75;
+  midpoint_displace_levels(h.data(), kSamples, midpoint_key(42), 0.5, 0.48,
+                           pool);
+  return h;
+}
+
+bool sameBits(const std::vector<double> &a, const std::vector<double> &b) {
+  return a.size() == b.size() &&
+         std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+} // namespace
+
+int main() {
+  const std::vector<double> serial = displace(nullptr);
+  ThreadPool two(1), eight(7);
+  CHECK(sameBits(serial, displace(&two)));
+  CHECK(sameBits(serial, displace(&eight)));
+
+  // Nested inside a task the pool is held, so the call runs serially.
+  std::vector<double> nested;
+  eight.parallelFor(2, [&](int i) {
+    if (i == 0)
+      nested = displace(&eight);
+  });
+  CHECK(sameBits(serial, nested));
+
+  return test_result("midpoint_test");
+}
@@ -0,0 +1,70 @@
+// Raster and composite modes are different ways to draw the same frame: every
+// combination must give identical pixels (Scene.h).
+#include "Scene.h"
+#include "ScenePresets.h"
+#include "TestUtil.h"
+
+#include <vector>
+
+namespace {
+
+// Odd sizes leave tails after the vector fills.
+constexpr int kWidth = 641, kHeight = 361;
+constexpr size_t kRidges = 8;
+
+// FNV-1a over the frame.
+uint64_t frameHash(const std::vector<uint32_t> &fb) {
+  uint64_t h = 0xCBF29CE484222325ull;
+  for (uint32_t p : fb)
+    for (int b = 0; b < 32; b += 8) {
+      h ^= (p >> b) & 0xFF;
+      h *= 0x100000001B3ull;
+    }
+  return h;
+}
+
+uint64_t renderHash(Scene &scene, CompositeMode composite, RasterMode raster,
+                    bool antiAlias) {
+  std::vector<uint32_t> fb(size_t(kWidth) * kHeight, 0u);
+  scene.setCompositeMode(composite);
+  scene.setRasterMode(raster);
+  scene.setAntiAliasing(antiAlias);
+  scene.markDirty();
+  scene.render(fb.data(), kWidth);
+  return frameHash(fb);
+}
+
+// Columns vs Spans and Painter vs FrontToBack, with and without AA, serial
+// and on each pool, against the serial Painter/Columns frame.
+void modesAgree(Scene &scene,
+                const std::vector<std::shared_ptr<ThreadPool>> &pools) {
+  for (bool antiAlias : {false, true}) {
+    scene.setThreadPool(nullptr);
+    const uint64_t reference = renderHash(scene, CompositeMode::Painter,
+                                          RasterMode::Columns, antiAlias);
+    for (const auto &pool : pools) {
+      scene.setThreadPool(pool);
+      for (CompositeMode composite :
+           {CompositeMode::Painter, CompositeMode::FrontToBack})
+        for (RasterMode raster : {RasterMode::Columns, RasterMode::Spans})
+          CHECK_OP(renderHash(scene, composite, raster, antiAlias), ==,
+                   reference);
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  // No pool, one helper and more helpers than this machine may have cores.
+  const std::vector<std::shared_ptr<ThreadPool>> pools = {
+      nullptr, std::make_shared<ThreadPool>(1),
+      std::make_shared<ThreadPool>(7)};
+  for (uint64_t seed : {1ull, 7ull, 42ull}) {
+    Scene scene(kWidth, kHeight, getNordScheme());
+    scene.setMountains(makeRandomMountainsWithPalette(
+        kRidges, kWidth, NORD_PALETTE, getNordScheme(), seed));
+    modesAgree(scene, pools);
+  }
+  return test_result("render_equivalence_test");
+}
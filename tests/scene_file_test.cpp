@@ -0,0 +1,121 @@
+// A saved scene loads back to the same pixels, and scene files whose
+// checksum matches but whose contents cannot make a scene are rejected on
+// load (SceneFile.h).
+#include "Scene.h"
+#include "SceneFile.h"
+#include "ScenePresets.h"
+#include "TestUtil.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string &scenePath() {
+  static const std::string path =
+      (std::filesystem::temp_directory_path() / "scene_file_test.mtn")
+          .string();
+  return path;
+}
+
+std::vector<uint8_t> readFile(const std::string &path) {
+  std::vector<uint8_t> bytes;
+  if (FILE *f = std::fopen(path.c_str(), "rb")) {
+    std::fseek(f, 0, SEEK_END);
+    bytes.resize(size_t(std::ftell(f)));
+    std::fseek(f, 0, SEEK_SET);
+    if (std::fread(bytes.data(), 1, bytes.size(), f) != bytes.size())
+      bytes.clear();
+    std::fclose(f);
+  }
+  return bytes;
+}
+
+// Write 'bytes' with a fresh checksum, so only validation can reject them.
+bool loads(std::vector<uint8_t> bytes) {
+  SceneFileHeader h;
+  std::memcpy(&h, bytes.data(), sizeof(h));
+  h.checksum =
+      scene_file_checksum(bytes.data() + sizeof(h), bytes.size() - sizeof(h));
+  std::memcpy(bytes.data(), &h, sizeof(h));
+  FILE *f = std::fopen(scenePath().c_str(), "wb");
+  if (!f)
+    return false;
+  std::fwrite(bytes.data(), 1, bytes.size(), f);
+  std::fclose(f);
+  std::string error;
+  return read_scene_file(scenePath(), nullptr, &error) != nullptr;
+}
+
+std::vector<uint32_t> render(Scene &scene) {
+  std::vector<uint32_t> fb(size_t(scene.width()) * scene.height());
+  scene.render(fb.data(), scene.width());
+  return fb;
+}
+
+template <class T>
+void patch(std::vector<uint8_t> &bytes, size_t offset, T value) {
+  std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+} // namespace
+
+int main() {
+  for (bool withPyramids : {false, true}) {
+    Scene scene(320, 200, getNordScheme());
+    scene.setMountains(makeRandomMountainsWithPalette(
+        3, 320, NORD_PALETTE, getNordScheme(), 5));
+    CHECK(write_scene_file(scene, scenePath(), withPyramids));
+    const std::vector<uint8_t> good = readFile(scenePath());
+    CHECK(!good.empty());
+    if (good.empty())
+      continue;
+    CHECK(loads(good));
+    auto loaded = read_scene_file(scenePath());
+    CHECK(loaded != nullptr);
+    if (loaded)
+      CHECK(render(*loaded) == render(scene));
+
+    // Second record.
+    const size_t record = sizeof(SceneFileHeader) + sizeof(SceneFileMountain);
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    for (size_t field : {offsetof(SceneFileMountain, leftHeight),
+                         offsetof(SceneFileMountain, rightHeight),
+                         offsetof(SceneFileMountain, initialDisplacement)})
+      for (double value : {nan, inf, -inf}) {
+        std::vector<uint8_t> bad = good;
+        patch(bad, record + field, value);
+        CHECK(!loads(bad));
+      }
+
+    std::vector<uint8_t> wide = good;
+    patch(wide, record + offsetof(SceneFileMountain, width),
+          int32_t(kSceneFileMaxRidgeWidth + 1));
+    CHECK(!loads(wide));
+
+    std::vector<uint8_t> huge = good;
+    patch(huge, offsetof(SceneFileHeader, width),
+          int32_t(kSceneFileMaxSide + 1));
+    CHECK(!loads(huge));
+
+    // Pyramid heights become pixel rows, so they must be finite too.
+    SceneFileMountain r;
+    std::memcpy(&r, good.data() + record, sizeof(r));
+    CHECK_OP(r.pyramidOffset != 0, ==, withPyramids);
+    if (r.pyramidOffset != 0)
+      for (double value : {nan, inf, -inf}) {
+        std::vector<uint8_t> bad = good;
+        patch(bad, size_t(r.pyramidOffset) + 8 * sizeof(double), value);
+        CHECK(!loads(bad));
+      }
+  }
+  std::remove(scenePath().c_str());
+  return test_result("scene_file_test");
+}
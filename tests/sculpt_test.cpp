@@ -0,0 +1,73 @@
+// Sculpting a hashed midpoint ridge moves the chosen sample to the target
+// height, touches nothing outside the range it reports, and doing it twice
+// gives what doing it once did (RidgeGenerator::sculpt()).
+#include "MountainParams.h"
+#include "RidgeGenerator.h"
+#include "TestUtil.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+bool sameBits(const double *a, const double *b, size_t count) {
+  return std::memcmp(a, b, count * sizeof(double)) == 0;
+}
+
+// Sculpt sample 'at' of a fresh ridge to 'height' and check it.
+void sculptAt(int width, int at, double height, int radius) {
+  MountainParams p;
+  p.width = width;
+  p.seed = 77u;
+  p.algorithm = RidgeAlgorithm::MidpointHashed;
+  auto gen = make_ridge_generator(p);
+  std::vector<double> original;
+  const double scale = gen->generate(original, nullptr);
+  const int count = int(original.size());
+
+  std::vector<double> once = original;
+  int first = -1, last = -1;
+  CHECK(gen->sculpt(once.data(), count, scale, at, height, radius, &first,
+                    &last));
+  CHECK(first >= 0 && first <= at && at <= last && last < count);
+  if (!(first >= 0 && first <= at && at <= last && last < count))
+    return;
+  CHECK_OP(std::fabs(once[size_t(at)] - height), <, 1e-12);
+  CHECK(sameBits(once.data(), original.data(), size_t(first)));
+  CHECK(sameBits(once.data() + last + 1, original.data() + last + 1,
+                 size_t(count - last - 1)));
+
+  std::vector<double> twice = once;
+  CHECK(gen->sculpt(twice.data(), count, scale, at, height, radius, &first,
+                    &last));
+  // The second pass moves the ends by the first one's rounding error only.
+  for (int i = 0; i < count; ++i)
+    CHECK_OP(std::fabs(twice[size_t(i)] - once[size_t(i)]), <, 1e-12);
+}
+
+} // namespace
+
+int main() {
+  // Interior, lattice points, both ends and the shrinking intervals near
+  // the right end of a width that is not a power of two plus one.
+  for (int width : {1025, 1000})
+    for (int at : {0, 1, 256, 300, 511, 512, 700, width - 2, width - 1})
+      for (int radius : {1, 8, 64})
+        for (double height : {0.1, 0.9})
+          sculptAt(width, at, height, radius);
+
+  // Other engines cannot sculpt and leave the samples alone.
+  MountainParams p;
+  p.algorithm = RidgeAlgorithm::FbmNoise;
+  auto gen = make_ridge_generator(p);
+  std::vector<double> samples;
+  const double scale = gen->generate(samples, nullptr);
+  const std::vector<double> before = samples;
+  int first = 0, last = 0;
+  CHECK(!gen->sculpt(samples.data(), int(samples.size()), scale, 10, 0.5, 8,
+                     &first, &last));
+  CHECK(samples == before);
+
+  return test_result("sculpt_test");
+}